@@ -17,7 +17,10 @@
 #ifndef LIBP_KLV_HPP
 #define LIBP_KLV_HPP
 
-#include <p/endian.hpp>
+#include <q/endian.hpp>
+
+#include <cstdint>
+#include <cstring>
 
 #define LIBP_PACKED __attribute__(( __packed__ ))
 
@@ -54,7 +57,7 @@ public:
 
 	std::uint8_t* value( )
 	{
-		return static_cast< std::uint8_t* >( this ) + 16;
+		return reinterpret_cast< std::uint8_t* >( this ) + 16;
 	}
 
 protected:
@@ -66,8 +69,8 @@ protected:
 	~klv( ) { }
 
 private:
-	le< std::uint64_t > key_;
-	le< std::uint64_t > len_;
+	q::le< std::uint64_t > key_;
+	q::le< std::uint64_t > len_;
 };
 
 } // namespace detail
@@ -84,6 +87,7 @@ public:
 
 template< std::uint64_t Key >
 struct dynamic_klv
+: public detail::klv
 {
 public:
 	dynamic_klv( std::uint64_t len )
@@ -91,6 +95,251 @@ public:
 	{ }
 };
 
+/**
+ * The encoding of KLV headers (the key and the length preceding the value).
+ *
+ * fixed:   a 64 bit little endian key followed by a 64 bit little endian
+ *          length, i.e. always 16 bytes, as detail::klv.
+ * compact: the key followed by the length, both as unsigned LEB128 varints,
+ *          i.e. 2 bytes for small keys and values up to 127 bytes, and at
+ *          most 20 bytes.
+ */
+enum class klv_format : std::uint8_t
+{
+	fixed = 0,
+	compact = 1,
+};
+
+/**
+ * A decoded KLV header. value_offset is the offset of the value relative to
+ * the start of the header, i.e. the size of the header.
+ */
+struct klv_header
+{
+	std::uint64_t key;
+	std::uint64_t length;
+	std::size_t value_offset;
+};
+
+constexpr std::size_t fixed_klv_header_size = 16;
+constexpr std::size_t max_varint_size = 10;
+constexpr std::size_t max_klv_header_size = 2 * max_varint_size;
+
+namespace detail {
+
+inline std::size_t varint_size( std::uint64_t value ) noexcept
+{
+	std::size_t size = 1;
+	while ( value >= 0x80 )
+	{
+		value >>= 7;
+		++size;
+	}
+	return size;
+}
+
+inline std::uint8_t* encode_varint( std::uint64_t value, std::uint8_t* out )
+noexcept
+{
+	while ( value >= 0x80 )
+	{
+		*out++ = static_cast< std::uint8_t >( value | 0x80 );
+		value >>= 7;
+	}
+	*out++ = static_cast< std::uint8_t >( value );
+	return out;
+}
+
+/**
+ * Decodes a varint byte by byte. Returns the number of bytes consumed, or 0
+ * if the varint is truncated or overflows 64 bits.
+ */
+inline std::size_t decode_varint_slow(
+	const std::uint8_t* in, std::size_t size, std::uint64_t& value )
+noexcept
+{
+	value = 0;
+
+	for ( std::size_t i = 0; i < size && i < max_varint_size; ++i )
+	{
+		std::uint64_t bits = in[ i ] & 0x7F;
+
+		if ( i == max_varint_size - 1 && bits > 1 )
+			return 0;
+
+		value |= bits << ( 7 * i );
+
+		if ( !( in[ i ] & 0x80 ) )
+			return i + 1;
+	}
+
+	return 0;
+}
+
+inline unsigned count_trailing_zeros( std::uint64_t value ) noexcept
+{
+	return __builtin_ctzll( value );
+}
+
+/**
+ * Decodes a varint of up to 8 bytes (56 bits) from one 64 bit load, without
+ * any per-byte branches: the end is found from the continuation bits, and
+ * the 7 bit groups are compacted pairwise (SWAR). Longer varints and the last
+ * bytes of a buffer are decoded byte by byte.
+ */
+inline std::size_t decode_varint(
+	const std::uint8_t* in, std::size_t size, std::uint64_t& value )
+noexcept
+{
+	if ( size < 8 )
+		return decode_varint_slow( in, size, value );
+
+	q::le< std::uint64_t > raw;
+	std::memcpy( &raw, in, sizeof raw );
+	std::uint64_t word = raw;
+
+	const std::uint64_t ends = ~word & 0x8080808080808080ULL;
+
+	if ( !ends )
+		return decode_varint_slow( in, size, value );
+
+	const std::size_t length = ( count_trailing_zeros( ends ) >> 3 ) + 1;
+
+	if ( length < 8 )
+		word &= ( std::uint64_t( 1 ) << ( length * 8 ) ) - 1;
+	word &= 0x7F7F7F7F7F7F7F7FULL;
+
+	word = ( ( word & 0x7F007F007F007F00ULL ) >> 1 ) |
+		( word & 0x007F007F007F007FULL );
+	word = ( ( word & 0x3FFF00003FFF0000ULL ) >> 2 ) |
+		( word & 0x00003FFF00003FFFULL );
+	word = ( ( word & 0x0FFFFFFF00000000ULL ) >> 4 ) |
+		( word & 0x000000000FFFFFFFULL );
+
+	value = word;
+	return length;
+}
+
+} // namespace detail
+
+/**
+ * The size of a header of @c format for @c key and @c length.
+ */
+inline std::size_t klv_header_size(
+	klv_format format, std::uint64_t key, std::uint64_t length ) noexcept
+{
+	if ( format == klv_format::fixed )
+		return fixed_klv_header_size;
+
+	return detail::varint_size( key ) + detail::varint_size( length );
+}
+
+/**
+ * Encodes a header into @c out, which must have room for at least
+ * klv_header_size( ) (or max_klv_header_size) bytes. Returns the number of
+ * bytes written.
+ */
+inline std::size_t encode_klv_header(
+	klv_format format,
+	std::uint64_t key,
+	std::uint64_t length,
+	std::uint8_t* out
+) noexcept
+{
+	if ( format == klv_format::fixed )
+	{
+		q::le< std::uint64_t > fixed[ 2 ] = { key, length };
+		std::memcpy( out, fixed, fixed_klv_header_size );
+		return fixed_klv_header_size;
+	}
+
+	auto end = detail::encode_varint( key, out );
+	end = detail::encode_varint( length, end );
+	return end - out;
+}
+
+/**
+ * Decodes a header from the @c size bytes at @c in. Returns false if the
+ * header is incomplete (or, for compact headers, malformed).
+ */
+inline bool decode_klv_header(
+	klv_format format,
+	const std::uint8_t* in,
+	std::size_t size,
+	klv_header& header
+) noexcept
+{
+	if ( format == klv_format::fixed )
+	{
+		if ( size < fixed_klv_header_size )
+			return false;
+
+		q::le< std::uint64_t > fixed[ 2 ];
+		std::memcpy( fixed, in, fixed_klv_header_size );
+
+		header.key = fixed[ 0 ];
+		header.length = fixed[ 1 ];
+		header.value_offset = fixed_klv_header_size;
+		return true;
+	}
+
+	auto key_size = detail::decode_varint( in, size, header.key );
+	if ( !key_size )
+		return false;
+
+	auto length_size = detail::decode_varint(
+		in + key_size, size - key_size, header.length );
+	if ( !length_size )
+		return false;
+
+	header.value_offset = key_size + length_size;
+	return true;
+}
+
+/**
+ * Decodes the headers of consecutive KLVs (header followed by value) in the
+ * @c size bytes at @c in, into at most @c max_headers elements of @c headers.
+ * The value_offset of each header is made relative to @c in.
+ *
+ * Stops at the first incomplete KLV (i.e. whose header or value isn't fully
+ * within the buffer), and returns the number of headers decoded. @c consumed
+ * is set to the number of bytes of the decoded KLVs, i.e. where to continue
+ * when more data is available.
+ */
+inline std::size_t decode_klv_headers(
+	klv_format format,
+	const std::uint8_t* in,
+	std::size_t size,
+	klv_header* headers,
+	std::size_t max_headers,
+	std::size_t& consumed
+) noexcept
+{
+	std::size_t offset = 0;
+	std::size_t count = 0;
+
+	while ( count < max_headers )
+	{
+		klv_header& header = headers[ count ];
+
+		if ( !decode_klv_header(
+			format, in + offset, size - offset, header
+		) )
+			break;
+
+		std::size_t available = size - offset - header.value_offset;
+		if ( header.length > available )
+			break;
+
+		header.value_offset += offset;
+		offset = header.value_offset + header.length;
+		++count;
+	}
+
+	consumed = offset;
+	return count;
+}
+
 } // namespace p
 
 #endif // LIBP_KLV_HPP
@@ -24,19 +24,114 @@
 #include <q/threadpool.hpp>
 #include <q/scope.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #define Q_TEST_MAKE_SCOPE( name ) \
 	class name : public ::q::test::fixture { }
 
+/**
+ * Like Q_TEST_MAKE_SCOPE, but the fixture runs its tp_queue on a threadpool
+ * shared by all such tests in the process (see q::test::runtime_mode).
+ */
+#define Q_TEST_MAKE_SHARED_SCOPE( name ) \
+	class name : public ::q::test::fixture \
+	{ \
+	public: \
+		name( ) \
+		: ::q::test::fixture( ::q::test::runtime_mode::shared ) \
+		{ } \
+	}
+
+// Define QTEST_SHARED_RUNTIME to make all fixtures use the shared runtime
+#ifdef QTEST_SHARED_RUNTIME
+#	define QTEST_DEFAULT_RUNTIME_MODE ::q::test::runtime_mode::shared
+#else
+#	define QTEST_DEFAULT_RUNTIME_MODE ::q::test::runtime_mode::per_test
+#endif
+
 namespace q { namespace test {
 
+/**
+ * per_test: Every test creates (and joins) its own threadpool.
+ *
+ * shared: The threadpool is created once per process and reused. Each test
+ * gets a fresh tp_queue which forwards to it, and teardown waits for the
+ * test's tasks on the pool to finish (or fails the test if they don't).
+ * Tests must not terminate or re-configure tp in this mode.
+ */
+enum class runtime_mode
+{
+	per_test,
+	shared
+};
+
+namespace detail {
+
+class shared_runtime
+{
+public:
+	static shared_runtime& get( )
+	{
+		// Deliberately leaked, the threads are kept until the process
+		// exits.
+		static shared_runtime* runtime = new shared_runtime( );
+		return *runtime;
+	}
+
+	const std::shared_ptr< q::threadpool >& threadpool( ) const
+	{
+		return tp_;
+	}
+
+	const q::queue_ptr& queue( ) const
+	{
+		return queue_;
+	}
+
+private:
+	shared_runtime( )
+	: termination_queue_( q::queue::construct( 0 ) )
+	{
+		std::tie( tp_, queue_ ) = q::make_event_dispatcher_and_queue<
+			q::threadpool, q::direct_scheduler
+		>( "shared test pool", termination_queue_, 2 );
+	}
+
+	q::queue_ptr termination_queue_;
+	std::shared_ptr< q::threadpool > tp_;
+	q::queue_ptr queue_;
+};
+
+/**
+ * A task forwarded from a test's tp_queue to the shared pool, counting the
+ * test's tasks which haven't finished yet.
+ */
+struct counted_task
+{
+	void operator( )( ) noexcept
+	{
+		task_( );
+		in_flight_->fetch_sub( 1 );
+	}
+
+	q::task task_;
+	std::shared_ptr< std::atomic< std::size_t > > in_flight_;
+};
+
+} // namespace detail
+
 class fixture
 #ifdef QTEST_BACKEND_FIXTURE_CLASS
 : public QTEST_BACKEND_FIXTURE_CLASS
 #endif
 {
 public:
-	fixture( )
-	: mutex_( "q test fixture" )
+	fixture( runtime_mode mode = QTEST_DEFAULT_RUNTIME_MODE )
+	: mode_( mode )
+	, in_flight_( std::make_shared< std::atomic< std::size_t > >( 0 ) )
+	, mutex_( "q test fixture" )
 	, started_( false )
 	{
 #ifndef QTEST_BACKEND_FIXTURE_SETUP
@@ -95,9 +190,13 @@ protected:
 			q::blocking_dispatcher, q::direct_scheduler
 		>( "all" );
 
-		std::tie( tp, tp_queue ) = q::make_event_dispatcher_and_queue<
-			q::threadpool, q::direct_scheduler
-		>( "test pool", queue, 2 );
+		if ( mode_ == runtime_mode::shared )
+			setup_shared_threadpool( );
+		else
+			std::tie( tp, tp_queue ) =
+				q::make_event_dispatcher_and_queue<
+					q::threadpool, q::direct_scheduler
+				>( "test pool", queue, 2 );
 
 		on_setup( );
 
@@ -118,18 +217,39 @@ protected:
 
 		on_teardown( );
 
-		tp->terminate( q::termination::linger )
-		.finally( [ this ]( )
+		if ( mode_ == runtime_mode::shared )
 		{
-			tp->await_termination( );
+			auto deadline = q::timer::clock::now( ) +
+				std::chrono::seconds( 5 );
+
+			terminate_when_quiescent( deadline );
+
+			bd->start( );
+
+			bd->await_termination( );
+
+			// Tasks may have been forwarded to the pool by the
+			// last tasks on the (now terminated) main queue
+			await_quiescence( deadline );
+
 			tp.reset( );
 			tp_queue.reset( );
-			bd->terminate( q::termination::linger );
-		}, queue );
+		}
+		else
+		{
+			tp->terminate( q::termination::linger )
+			.finally( [ this ]( )
+			{
+				tp->await_termination( );
+				tp.reset( );
+				tp_queue.reset( );
+				bd->terminate( q::termination::linger );
+			}, queue );
 
-		bd->start( );
+			bd->start( );
 
-		bd->await_termination( );
+			bd->await_termination( );
+		}
 		bd.reset( );
 		queue.reset( );
 		test_scopes_.clear( );
@@ -226,6 +346,79 @@ protected:
 	q::test::spy spy;
 
 private:
+	void setup_shared_threadpool( )
+	{
+		auto& runtime = detail::shared_runtime::get( );
+
+		tp = runtime.threadpool( );
+		tp_queue = q::queue::construct( 0 );
+
+		std::weak_ptr< q::queue > weak_source = tp_queue;
+		auto target = runtime.queue( );
+		auto in_flight = in_flight_;
+
+		tp_queue->set_consumer( [ weak_source, target, in_flight ]( )
+		{
+			auto source = weak_source.lock( );
+			if ( !source )
+				return;
+
+			auto tt = source->pop( );
+			if ( !tt )
+				return;
+
+			in_flight->fetch_add( 1 );
+
+			q::task forwarded( detail::counted_task{
+				std::move( tt.task_ ), in_flight } );
+
+			if ( tt.is_timed( ) )
+				target->push(
+					std::move( forwarded ),
+					tt.wait_until_,
+					tt.slack_ );
+			else
+				target->push( std::move( forwarded ) );
+		}, tp->parallelism( ) );
+	}
+
+	// Terminates the blocking dispatcher once the test has no tasks left
+	// on the shared pool, polling from the main queue.
+	void terminate_when_quiescent( q::timer::point_type deadline )
+	{
+		queue->push( [ this, deadline ]( ) noexcept
+		{
+			if (
+				in_flight_->load( ) == 0 ||
+				q::timer::clock::now( ) >= deadline
+			)
+				bd->terminate( q::termination::linger );
+			else
+				queue->push( [ this, deadline ]( ) noexcept
+				{
+					terminate_when_quiescent( deadline );
+				}, q::timer::clock::now( ) +
+					std::chrono::milliseconds( 1 ) );
+		} );
+	}
+
+	void await_quiescence( q::timer::point_type deadline )
+	{
+		while (
+			in_flight_->load( ) != 0 &&
+			q::timer::clock::now( ) < deadline
+		)
+			std::this_thread::sleep_for(
+				std::chrono::milliseconds( 1 ) );
+
+		auto in_flight = in_flight_->load( );
+		if ( in_flight != 0 )
+			QTEST_BACKEND_FAIL(
+				"Test left " << in_flight << " task(s) running "
+				"on the shared threadpool"
+			);
+	}
+
 	q::promise< > await_all( )
 	{
 		std::vector< q::promise< > > promises_;
@@ -246,6 +439,9 @@ private:
 		} );
 	}
 
+	const runtime_mode mode_;
+	std::shared_ptr< std::atomic< std::size_t > > in_flight_;
+
 	q::mutex mutex_;
 	std::vector< q::promise< > > awaiting_promises_;
 
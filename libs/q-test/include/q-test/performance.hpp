@@ -0,0 +1,195 @@
+/*
+ * Copyright 2017 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_TEST_PERFORMANCE_HPP
+#define LIBQ_TEST_PERFORMANCE_HPP
+
+#include <q/timer.hpp>
+
+#include <cstddef>
+#include <chrono>
+
+/**
+ * The performance expectations run a statement (possibly a block in braces)
+ * and fail the test if it allocates or takes more than expected:
+ *
+ *   EXPECT_MAX_ALLOCATIONS( 2, {
+ *       p = p.then( fn );
+ *   } );
+ *
+ *   EXPECT_MAX_ALLOCATIONS_PER_ITERATION( 2, 1000, { ... } );
+ *   EXPECT_MAX_TIME_PER_ITERATION( std::chrono::microseconds( 5 ), 1000, { ... } );
+ *
+ * Allocations are counted on the current thread, through an operator new
+ * replacement in the q-test library. It is linked into the test program when
+ * these helpers (or q::test::allocation_counter) are used.
+ */
+
+#define EXPECT_MAX_ALLOCATIONS( max, ... ) \
+	EXPECT_MAX_ALLOCATIONS_PER_ITERATION( max, 1, __VA_ARGS__ )
+
+#define EXPECT_MAX_ALLOCATIONS_PER_ITERATION( max, iterations, ... ) \
+	do { \
+		const std::size_t qtest_iterations_ = ( iterations ); \
+		::q::test::allocation_counter qtest_counter_; \
+		for ( std::size_t qtest_i_ = 0; \
+			qtest_i_ < qtest_iterations_; ++qtest_i_ ) \
+		{ __VA_ARGS__ ; } \
+		qtest_counter_.stop( ); \
+		::q::test::expect_max_allocations( \
+			__FILE__, __LINE__, #__VA_ARGS__, \
+			qtest_counter_.allocations( ), qtest_iterations_, \
+			( max ) ); \
+	} while ( false )
+
+#define EXPECT_MAX_TIME_PER_ITERATION( max, iterations, ... ) \
+	do { \
+		const std::size_t qtest_iterations_ = ( iterations ); \
+		::q::test::stopwatch qtest_stopwatch_; \
+		for ( std::size_t qtest_i_ = 0; \
+			qtest_i_ < qtest_iterations_; ++qtest_i_ ) \
+		{ __VA_ARGS__ ; } \
+		::q::test::expect_max_time( \
+			__FILE__, __LINE__, #__VA_ARGS__, \
+			qtest_stopwatch_.elapsed( ), qtest_iterations_, \
+			( max ) ); \
+	} while ( false )
+
+
+namespace q { namespace test {
+
+namespace detail {
+
+/**
+ * The number of allocations (and allocated bytes) made by the current thread
+ * since it started. Defined next to the operator new replacement.
+ */
+std::size_t thread_allocations( );
+std::size_t thread_allocated_bytes( );
+
+} // namespace detail
+
+/**
+ * Counts the heap allocations made by the current thread while it is alive
+ * (or until stop( ) is called).
+ */
+class allocation_counter
+{
+public:
+	allocation_counter( )
+	: allocations_( detail::thread_allocations( ) )
+	, bytes_( detail::thread_allocated_bytes( ) )
+	, stopped_( false )
+	{ }
+
+	void stop( )
+	{
+		if ( stopped_ )
+			return;
+
+		allocations_ = detail::thread_allocations( ) - allocations_;
+		bytes_ = detail::thread_allocated_bytes( ) - bytes_;
+		stopped_ = true;
+	}
+
+	std::size_t allocations( ) const
+	{
+		return stopped_
+			? allocations_
+			: detail::thread_allocations( ) - allocations_;
+	}
+
+	std::size_t bytes( ) const
+	{
+		return stopped_
+			? bytes_
+			: detail::thread_allocated_bytes( ) - bytes_;
+	}
+
+private:
+	std::size_t allocations_;
+	std::size_t bytes_;
+	bool stopped_;
+};
+
+class stopwatch
+{
+public:
+	stopwatch( )
+	: start_( q::timer::clock::now( ) )
+	{ }
+
+	q::timer::duration_type elapsed( ) const
+	{
+		return q::timer::clock::now( ) - start_;
+	}
+
+private:
+	q::timer::point_type start_;
+};
+
+inline void expect_max_allocations(
+	const char* file,
+	long line,
+	const char* expr,
+	std::size_t allocations,
+	std::size_t iterations,
+	std::size_t max_per_iteration
+)
+{
+	if ( allocations <= max_per_iteration * iterations )
+		return;
+
+	QTEST_BACKEND_FAIL_AT( file, line,
+		"Expected at most " << max_per_iteration
+		<< " allocation(s) per iteration of: " << expr << LIBQ_EOL
+		<< "Got " << allocations << " allocation(s) in "
+		<< iterations << " iteration(s)"
+	);
+}
+
+template< typename Rep, typename Period >
+void expect_max_time(
+	const char* file,
+	long line,
+	const char* expr,
+	q::timer::duration_type elapsed,
+	std::size_t iterations,
+	std::chrono::duration< Rep, Period > max_per_iteration
+)
+{
+	typedef std::chrono::duration< double, std::micro > micros;
+
+	auto max = std::chrono::duration_cast< q::timer::duration_type >(
+		max_per_iteration );
+
+	if ( elapsed <= max * iterations )
+		return;
+
+	auto per_iteration = micros( elapsed ).count( ) /
+		( iterations ? iterations : 1 );
+
+	QTEST_BACKEND_FAIL_AT( file, line,
+		"Expected at most " << micros( max ).count( )
+		<< "us per iteration of: " << expr << LIBQ_EOL
+		<< "Got " << per_iteration << "us per iteration ("
+		<< iterations << " iteration(s))"
+	);
+}
+
+} } // namespace test, namespace q
+
+#endif // LIBQ_TEST_PERFORMANCE_HPP
@@ -20,5 +20,6 @@
 #include <q-test/backend.hpp>
 #include <q-test/spy.hpp>
 #include <q-test/fixture.hpp>
+#include <q-test/performance.hpp>
 
 #endif // LIBQ_TEST_QTEST_HPP
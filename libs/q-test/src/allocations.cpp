@@ -0,0 +1,130 @@
+/*
+ * Copyright 2017 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The global operator new replacement used for allocation counting. This
+// translation unit is only linked into a test program if it references
+// q::test::detail::thread_allocations( ) (e.g. through the performance
+// expectation macros), so programs which don't count allocations keep the
+// default allocator.
+
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+namespace {
+
+// Trivially constructible, so safe to use from within operator new at any
+// point in a thread's life.
+thread_local std::size_t allocations_ = 0;
+thread_local std::size_t allocated_bytes_ = 0;
+
+void* counted_allocate( std::size_t size )
+{
+	++allocations_;
+	allocated_bytes_ += size;
+
+	if ( size == 0 )
+		size = 1;
+
+	while ( true )
+	{
+		void* ptr = std::malloc( size );
+		if ( ptr )
+			return ptr;
+
+		std::new_handler handler = std::get_new_handler( );
+		if ( !handler )
+			return nullptr;
+
+		handler( );
+	}
+}
+
+} // anonymous namespace
+
+namespace q { namespace test { namespace detail {
+
+std::size_t thread_allocations( )
+{
+	return allocations_;
+}
+
+std::size_t thread_allocated_bytes( )
+{
+	return allocated_bytes_;
+}
+
+} } } // namespace detail, namespace test, namespace q
+
+void* operator new( std::size_t size )
+{
+	void* ptr = counted_allocate( size );
+	if ( !ptr )
+		throw std::bad_alloc( );
+	return ptr;
+}
+
+void* operator new[ ]( std::size_t size )
+{
+	void* ptr = counted_allocate( size );
+	if ( !ptr )
+		throw std::bad_alloc( );
+	return ptr;
+}
+
+void* operator new( std::size_t size, const std::nothrow_t& ) noexcept
+{
+	try
+	{
+		return counted_allocate( size );
+	}
+	catch ( ... )
+	{
+		return nullptr;
+	}
+}
+
+void* operator new[ ]( std::size_t size, const std::nothrow_t& ) noexcept
+{
+	try
+	{
+		return counted_allocate( size );
+	}
+	catch ( ... )
+	{
+		return nullptr;
+	}
+}
+
+void operator delete( void* ptr ) noexcept
+{
+	std::free( ptr );
+}
+
+void operator delete[ ]( void* ptr ) noexcept
+{
+	std::free( ptr );
+}
+
+void operator delete( void* ptr, const std::nothrow_t& ) noexcept
+{
+	std::free( ptr );
+}
+
+void operator delete[ ]( void* ptr, const std::nothrow_t& ) noexcept
+{
+	std::free( ptr );
+}
@@ -23,6 +23,8 @@
 
 namespace q {
 
+class memory_reservation;
+
 class byte_block
 {
 public:
@@ -32,6 +34,16 @@ public:
 	byte_block(
 		std::size_t size, std::shared_ptr< const std::uint8_t > data );
 
+	/**
+	 * Constructs a byte_block which keeps @c reservation (of a
+	 * memory_budget) until the data is freed, i.e. until this block and
+	 * all slices of it are destructed.
+	 */
+	byte_block(
+		std::size_t size,
+		std::shared_ptr< const std::uint8_t > data,
+		memory_reservation&& reservation );
+
 	void advance( std::size_t amount );
 
 	std::size_t size( ) const;
@@ -39,6 +39,12 @@ public:
 
 	q::expect< > await_termination( ) override;
 
+	/**
+	 * Returns the accumulated counters of this dispatcher. The busy time is
+	 * not measured.
+	 */
+	dispatcher_statistics statistics( ) const;
+
 protected:
 	blocking_dispatcher( const std::string& name );
 	blocking_dispatcher( )
@@ -17,14 +17,20 @@
 #ifndef LIBQ_CHANNEL_HPP
 #define LIBQ_CHANNEL_HPP
 
+#include <q/fwd.hpp>
 #include <q/exception.hpp>
 #include <q/mutex.hpp>
 #include <q/promise.hpp>
 #include <q/scope.hpp>
 #include <q/concurrency.hpp>
 #include <q/concurrency_counter.hpp>
+#include <q/memory_budget.hpp>
+#include <q/optional.hpp>
+#include <q/detail/stress.hpp>
 
+#include <algorithm>
 #include <list>
+#include <deque>
 #include <queue>
 #include <atomic>
 
@@ -32,14 +38,25 @@ namespace q {
 
 Q_MAKE_SIMPLE_EXCEPTION( channel_closed_exception );
 
-template< typename... T >
-class readable;
-
-template< typename... T >
-class writable;
+/**
+ * The outcome of readable::try_read( ).
+ */
+enum class read_status
+{
+	// A value was read
+	value,
+	// No value is buffered (yet)
+	empty,
+	// The channel is closed and drained, possibly with an error
+	closed
+};
 
-template< typename... T >
-class channel;
+template< typename Tuple >
+struct try_read_result
+{
+	read_status status;
+	optional< Tuple > value;
+};
 
 namespace detail {
 
@@ -226,8 +243,7 @@ public:
 		void set_closed( ) override
 		{
 			deferred->set_exception(
-				std::make_exception_ptr(
-					channel_closed_exception( ) ) );
+				cached_exception< channel_closed_exception >( ) );
 		}
 		void set_exception( std::exception_ptr e ) override
 		{
@@ -245,6 +261,41 @@ public:
 		std::shared_ptr< defer_type > deferred;
 	};
 
+	typedef optional< tuple_type > optional_type;
+	typedef detail::defer< optional_type > optional_defer_type;
+
+	struct optional_waiter_type
+	: waiter_type
+	{
+		void set_closed( ) override
+		{
+			deferred->set_value( optional_type( ) );
+		}
+		void set_exception( std::exception_ptr e ) override
+		{
+			deferred->set_exception( std::move( e ) );
+		}
+		void set_value( tuple_type&& t ) override
+		{
+			deferred->set_value( optional_type( std::move( t ) ) );
+		}
+
+		optional_waiter_type(
+			std::shared_ptr< optional_defer_type > deferred
+		)
+		: deferred( deferred )
+		{ }
+
+		std::shared_ptr< optional_defer_type > deferred;
+	};
+
+	// A writer waiting for room in the buffer (see write_async)
+	struct writer_waiter_type
+	{
+		tuple_type value;
+		std::shared_ptr< detail::defer< bool > > deferred;
+	};
+
 	template< typename FnValue, typename FnClosed >
 	struct fast_waiter_type_traits
 	{
@@ -426,8 +477,16 @@ public:
 	, paused_( false )
 	, buffer_count_( buffer_count )
 	, resume_count_( std::min( resume_count, buffer_count ) )
+	, budget_ptr_( nullptr )
+	, budget_listener_( 0 )
 	{ }
 
+	~shared_channel( )
+	{
+		if ( budget_ )
+			budget_->remove_listener( budget_listener_ );
+	}
+
 	Q_NODISCARD
 	std::size_t buffer_count( ) const
 	{
@@ -505,6 +564,8 @@ public:
 	Q_NODISCARD
 	bool write( tuple_type&& t )
 	{
+		Q_STRESS_POINT( "shared_channel::write" );
+
 		Q_AUTO_UNIQUE_LOCK( mutex_ );
 
 		if ( closed_.load( std::memory_order_seq_cst ) )
@@ -515,7 +576,7 @@ public:
 			if ( queue_.size( ) >= buffer_count_ )
 				paused_ = true;
 
-			queue_.push( std::move( t ) );
+			push_value( std::move( t ) );
 		}
 		else
 		{
@@ -534,9 +595,58 @@ public:
 		return write( tuple_type( t ) );
 	}
 
+	/**
+	 * Writes a value once there is room for it in the buffer. The returned
+	 * promise resolves to true when the value is accepted, or to false if
+	 * the channel is (or gets) closed before that, in which case the value
+	 * is dropped.
+	 *
+	 * Writers waiting for room are queued in FIFO order, and admitted one
+	 * by one as values are read, so that any number of producers using
+	 * write_async( ) keep at most buffer_count values buffered (but at
+	 * least one). Values written with write( ) bypass this queue.
+	 */
+	Q_NODISCARD
+	promise< bool > write_async( tuple_type&& t )
+	{
+		Q_STRESS_POINT( "shared_channel::write_async" );
+
+		Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+		if ( closed_.load( std::memory_order_seq_cst ) )
+			return q::with( default_queue_, false );
+
+		if ( !waiters_.empty( ) )
+		{
+			auto waiter = std::move( waiters_.front( ) );
+			waiters_.pop_front( );
+
+			waiter->set_value( std::move( t ) );
+
+			return q::with( default_queue_, true );
+		}
+
+		if ( writer_waiters_.empty( ) && has_room( ) )
+		{
+			push_value( std::move( t ) );
+
+			return q::with( default_queue_, true );
+		}
+
+		auto deferred = ::q::make_shared< detail::defer< bool > >(
+			default_queue_ );
+
+		writer_waiters_.push_back( { std::move( t ), deferred } );
+		paused_ = true;
+
+		return deferred->get_promise( );
+	}
+
 	Q_NODISCARD
 	promise< T... > read( )
 	{
+		Q_STRESS_POINT( "shared_channel::read" );
+
 		Q_AUTO_UNIQUE_LOCK( mutex_ );
 
 		if ( queue_.empty( ) )
@@ -546,8 +656,8 @@ public:
 					default_queue_,
 					std::get< 0 >( close_exception_ )
 					? std::get< 1 >( close_exception_ )
-					: std::make_exception_ptr(
-						channel_closed_exception( ) )
+					: cached_exception<
+						channel_closed_exception >( )
 				);
 
 			auto defer = ::q::make_shared< defer_type >(
@@ -561,25 +671,83 @@ public:
 		}
 		else
 		{
-			tuple_type t = std::move( queue_.front( ) );
-			queue_.pop( );
+			auto defer = ::q::make_shared< defer_type >(
+				default_queue_ );
+
+			defer->set_value( pop_value( ) );
+
+			return defer->get_promise( );
+		}
+	}
+
+	/**
+	 * Reads a value if one is buffered, without waiting, allocating
+	 * promises or using exceptions. If the channel is closed (and
+	 * drained), read_status::closed is returned, also when it was closed
+	 * with an error, which is available from get_exception( ).
+	 */
+	Q_NODISCARD
+	try_read_result< tuple_type > try_read( )
+	{
+		Q_STRESS_POINT( "shared_channel::try_read" );
+
+		Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+		try_read_result< tuple_type > result;
+
+		if ( queue_.empty( ) )
+		{
+			result.status = closed_.load( std::memory_order_seq_cst )
+				? read_status::closed
+				: read_status::empty;
+
+			return result;
+		}
+
+		result.status = read_status::value;
+		result.value.emplace( pop_value( ) );
 
-			if ( queue_.size( ) < resume_count_ && paused_ )
+		return result;
+	}
+
+	/**
+	 * Reads the next value, or an empty optional if the channel is (or
+	 * gets) closed without an error, so that the end of the stream isn't
+	 * signalled with an exception. If the channel is closed with an
+	 * error, the promise is rejected with it.
+	 */
+	Q_NODISCARD
+	promise< optional_type > read_optional( )
+	{
+		Q_STRESS_POINT( "shared_channel::read_optional" );
+
+		Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+		if ( queue_.empty( ) )
+		{
+			if ( closed_.load( std::memory_order_seq_cst ) )
 			{
-				auto self = this->shared_from_this( );
-				default_queue_->push( [ self ]( )
-				{
-					self->resume( );
-				} );
+				if ( std::get< 0 >( close_exception_ ) )
+					return reject< optional_type >(
+						default_queue_,
+						std::get< 1 >(
+							close_exception_ ) );
+
+				return q::with(
+					default_queue_, optional_type( ) );
 			}
 
-			auto defer = ::q::make_shared< defer_type >(
+			auto defer = ::q::make_shared< optional_defer_type >(
 				default_queue_ );
 
-			defer->set_value( std::move( t ) );
+			waiters_.push_back(
+				::q::make_unique< optional_waiter_type >(
+					defer ) );
 
 			return defer->get_promise( );
 		}
+
+		return q::with( default_queue_, optional_type( pop_value( ) ) );
 	}
 
 	/**
@@ -614,6 +782,8 @@ public:
 	>::type
 	read( FnValue&& fn_value, FnClosed&& fn_closed )
 	{
+		Q_STRESS_POINT( "shared_channel::read(2)" );
+
 		Q_AUTO_UNIQUE_LOCK( mutex_ );
 
 		typedef fast_waiter_type<
@@ -661,17 +831,7 @@ public:
 		}
 		else
 		{
-			tuple_type t = std::move( queue_.front( ) );
-			queue_.pop( );
-
-			if ( queue_.size( ) < resume_count_ )
-			{
-				auto self = this->shared_from_this( );
-				default_queue_->push( [ self ]( )
-				{
-					self->resume( );
-				} );
-			}
+			tuple_type t = pop_value( );
 
 			auto defer = ::q::make_shared< specific_defer_type >(
 				default_queue_ );
@@ -692,7 +852,48 @@ public:
 	Q_NODISCARD
 	inline bool should_write( ) const
 	{
-		return !paused_ && !closed_;
+		auto budget = budget_ptr_.load( std::memory_order_acquire );
+
+		return !paused_ && !closed_ && !( budget && budget->exhausted( ) );
+	}
+
+	/**
+	 * Accounts the values buffered in this channel in @c budget. While the
+	 * budget is exhausted, should_write( ) returns false, and the resume
+	 * notification is triggered when memory is available again.
+	 */
+	void set_memory_budget( std::shared_ptr< memory_budget > budget )
+	{
+		std::weak_ptr< shared_channel > weak_self =
+			this->shared_from_this( );
+		auto queue = default_queue_;
+
+		auto listener = budget->add_listener( [ weak_self, queue ]( )
+		{
+			queue->push( [ weak_self ]( )
+			{
+				auto self = weak_self.lock( );
+				if ( self )
+					self->trigger_resume_notification( );
+			} );
+		} );
+
+		std::shared_ptr< memory_budget > previous;
+		memory_budget::listener_id previous_listener;
+
+		{
+			Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+			previous = std::move( budget_ );
+			previous_listener = budget_listener_;
+
+			budget_ = std::move( budget );
+			budget_listener_ = listener;
+			budget_ptr_.store( budget_.get( ), std::memory_order_release );
+		}
+
+		if ( previous )
+			previous->remove_listener( previous_listener );
 	}
 
 	void set_resume_notification( shared_task fn, bool trigger_now )
@@ -734,6 +935,8 @@ public:
 			notification = resume_notification_;
 		}
 
+		Q_STRESS_POINT( "shared_channel::trigger_resume_notification" );
+
 		if ( notification )
 			notification( );
 	}
@@ -767,6 +970,11 @@ public:
 
 		while ( !queue_.empty( ) )
 			queue_.pop( );
+
+		while ( !reservations_.empty( ) )
+			reservations_.pop( );
+
+		admit_writers( );
 	}
 
 private:
@@ -805,15 +1013,97 @@ private:
 
 			waiters_.clear( );
 
+			for ( auto& writer : writer_waiters_ )
+				writer.deferred->set_value( false );
+
+			writer_waiters_.clear( );
+
 			scopes_.clear( );
 
 			notification = resume_notification_;
 		}
 
+		Q_STRESS_POINT( "shared_channel::close" );
+
 		if ( notification )
 			notification( );
 	}
 
+	/**
+	 * Pops the front value, and schedules a resume if the buffer is drained
+	 * below the resume count. Must be called with the mutex locked, and a
+	 * non-empty queue.
+	 */
+	tuple_type pop_value( )
+	{
+		tuple_type t = std::move( queue_.front( ) );
+		queue_.pop( );
+		pop_reservation( );
+
+		admit_writers( );
+
+		if ( queue_.size( ) < resume_count_ && paused_ )
+		{
+			auto self = this->shared_from_this( );
+			default_queue_->push( [ self ]( )
+			{
+				self->resume( );
+			} );
+		}
+
+		return t;
+	}
+
+	/**
+	 * Buffers a value, accounting it in the memory budget, if any. Must be
+	 * called with the mutex locked.
+	 */
+	void push_value( tuple_type&& t )
+	{
+		if ( budget_ )
+			reservations_.push( budget_->force_reserve(
+				memory_size_of( t ) ) );
+
+		queue_.push( std::move( t ) );
+	}
+
+	/**
+	 * Whether write_async( ) may buffer another value. A channel with a
+	 * buffer count of zero still buffers one value at a time.
+	 */
+	bool has_room( ) const
+	{
+		return queue_.size( ) < std::max< std::size_t >( buffer_count_, 1 );
+	}
+
+	/**
+	 * Buffers the values of waiting writers, in FIFO order, while there is
+	 * room for them. Must be called with the mutex locked.
+	 */
+	void admit_writers( )
+	{
+		while ( !writer_waiters_.empty( ) && has_room( ) )
+		{
+			auto& writer = writer_waiters_.front( );
+
+			push_value( std::move( writer.value ) );
+			writer.deferred->set_value( true );
+
+			writer_waiters_.pop_front( );
+		}
+	}
+
+	/**
+	 * The reservations belong to the most recently written values, as a
+	 * budget may be set after values have been written. Must be called
+	 * with the mutex locked, after a value has been popped.
+	 */
+	void pop_reservation( )
+	{
+		if ( reservations_.size( ) > queue_.size( ) )
+			reservations_.pop( );
+	}
+
 	inline void resume( )
 	{
 		if ( paused_.exchange( false ) )
@@ -828,6 +1118,7 @@ private:
 	// TODO: Make this lock-free and consider other list types
 	mutable mutex mutex_;
 	std::list< std::unique_ptr< waiter_type > > waiters_;
+	std::deque< writer_waiter_type > writer_waiters_;
 	std::queue< tuple_type > queue_;
 	// True if arbitrary exception, false if "closed exception"
 	std::tuple< bool, std::exception_ptr > close_exception_;
@@ -837,6 +1128,10 @@ private:
 	const std::size_t resume_count_;
 	shared_task resume_notification_;
 	std::vector< scope > scopes_;
+	std::shared_ptr< memory_budget > budget_;
+	std::atomic< memory_budget* > budget_ptr_;
+	memory_budget::listener_id budget_listener_;
+	std::queue< memory_reservation > reservations_;
 };
 
 template< typename... T >
@@ -926,6 +1221,38 @@ public:
 		} ) );
 	}
 
+	/**
+	 * Reads a buffered value, if any, without waiting. The status tells
+	 * whether a value was read, or if the channel is empty or closed.
+	 * This never throws or allocates, not even when the channel is closed.
+	 */
+	template< bool IsPromise = is_promise::value >
+	Q_NODISCARD
+	typename std::enable_if<
+		!IsPromise,
+		try_read_result< tuple_type >
+	>::type
+	try_read( )
+	{
+		return shared_channel_->try_read( );
+	}
+
+	/**
+	 * Like read( ), but resolves to an empty optional when the channel is
+	 * (or gets) closed, rather than rejecting with channel_closed_exception.
+	 * If the channel is closed with an error, the promise is rejected.
+	 */
+	template< bool IsPromise = is_promise::value >
+	Q_NODISCARD
+	typename std::enable_if<
+		!IsPromise,
+		promise< optional< tuple_type > >
+	>::type
+	read_optional( )
+	{
+		return shared_channel_->read_optional( );
+	}
+
 	template<
 		typename FnValue,
 		typename FnClosed,
@@ -1022,52 +1349,6 @@ public:
 			std::make_shared< concurrency_counter >(
 				get_queue( ), _concurrency );
 
-		auto cb =
-			[ self, _fn ]
-			( resolver< > resolve, rejecter< > reject )
-			mutable
-		{
-			typedef function< promise< >( ) > recurser_type;
-			auto recurser = std::make_shared< recurser_type >( );
-
-			auto completer = [ recurser, resolve ]( ) mutable
-			{
-				( *recurser ) = recurser_type( );
-				resolve( );
-			};
-
-			auto failer =
-				[ recurser, reject ]
-				( std::exception_ptr err )
-				mutable
-			{
-				( *recurser ) = recurser_type( );
-				reject( std::move( err ) );
-			};
-
-			auto recurser_fn =
-				[ self, _fn, recurser, completer, failer ]
-				( )
-				mutable
-			{
-				return self.read( _fn, completer )
-				.then( [ self, recurser ]( bool got_data )
-				mutable
-				{
-					if ( got_data )
-						return ( *recurser )( );
-					else
-						return q::with(
-							self.get_queue( ) );
-				} )
-				.fail( failer );
-			};
-
-			*recurser = std::move( recurser_fn );
-
-			ignore_result( ( *recurser )( ) );
-		};
-
 		auto cb_concurrent =
 			[ self, _fn, counter ]
 			( resolver< > resolve, rejecter< > reject )
@@ -1241,8 +1522,8 @@ public:
 		};
 
 		if ( _concurrency == 1 )
-			return q::make_promise(
-				get_queue( ), std::move( cb ) );
+			return consume_sequentially(
+				std::move( _fn ), is_promise( ) );
 		else
 			return q::make_promise(
 				get_queue( ), std::move( cb_concurrent ) );
@@ -1322,6 +1603,139 @@ private:
 		std::make_shared< detail::shared_channel_owner< T... > >( ch ) )
 	{ }
 
+	/**
+	 * Consumes the values of a channel of promises one at a time, using
+	 * read( fn_value, fn_closed ), which awaits the inner promises.
+	 */
+	template< typename Fn >
+	promise< > consume_sequentially( Fn _fn, std::true_type /* promise */ )
+	{
+		readable< T... > self = *this;
+
+		auto cb =
+			[ self, _fn ]
+			( resolver< > resolve, rejecter< > reject )
+			mutable
+		{
+			typedef function< promise< >( ) > recurser_type;
+			auto recurser = std::make_shared< recurser_type >( );
+
+			// The recurser only refers weakly to itself, to not
+			// form a cycle. It's kept alive by the pending read,
+			// and must not be cleared when completing, as it may
+			// still be running on another thread of the queue.
+			std::weak_ptr< recurser_type > weak_recurser = recurser;
+
+			auto completer = [ resolve ]( ) mutable
+			{
+				resolve( );
+			};
+
+			auto failer =
+				[ reject ]
+				( std::exception_ptr err )
+				mutable
+			{
+				reject( std::move( err ) );
+			};
+
+			auto recurser_fn =
+				[ self, _fn, weak_recurser, completer, failer ]
+				( )
+				mutable
+			{
+				auto recurser = weak_recurser.lock( );
+
+				return self.read( _fn, completer )
+				.then( [ self, recurser ]( bool got_data )
+				mutable
+				{
+					if ( got_data )
+						return ( *recurser )( );
+					else
+						return q::with(
+							self.get_queue( ) );
+				} )
+				.fail( failer );
+			};
+
+			*recurser = std::move( recurser_fn );
+
+			ignore_result( ( *recurser )( ) );
+		};
+
+		return q::make_promise( get_queue( ), std::move( cb ) );
+	}
+
+	/**
+	 * Consumes the values one at a time, using read_optional( ), so that
+	 * the end of the stream doesn't involve any exceptions. As with
+	 * read( fn_value, fn_closed ), an error from @c fn closes the channel.
+	 */
+	template< typename Fn >
+	promise< > consume_sequentially( Fn fn, std::false_type /* promise */ )
+	{
+		readable< T... > self = *this;
+
+		auto cb =
+			[ self, fn ]
+			( resolver< > resolve, rejecter< > reject )
+			mutable
+		{
+			typedef function< void( ) > recurser_type;
+			auto recurser = std::make_shared< recurser_type >( );
+
+			// The recurser only refers weakly to itself, to not
+			// form a cycle. It's kept alive by the pending read.
+			std::weak_ptr< recurser_type > weak_recurser = recurser;
+
+			auto recurser_fn =
+				[ self, fn, weak_recurser, resolve, reject ]
+				( )
+				mutable
+			{
+				auto recurser = weak_recurser.lock( );
+				auto shared_channel = self.shared_channel_;
+				auto queue = self.get_queue( );
+
+				self.read_optional( )
+				.then( [ fn, recurser, resolve, queue ](
+					optional< tuple_type >&& value
+				)
+				mutable -> promise< >
+				{
+					if ( !value )
+					{
+						resolve( );
+						return q::with( queue );
+					}
+
+					return q::with( queue, std::move( *value ) )
+					.then( Fn( fn ) )
+					.then( [ recurser ]( )
+					{
+						( *recurser )( );
+					} );
+				} )
+				.fail( [ shared_channel, reject ](
+					std::exception_ptr e
+				)
+				mutable
+				{
+					shared_channel->close( e );
+					shared_channel->clear( );
+					reject( std::move( e ) );
+				} );
+			};
+
+			*recurser = std::move( recurser_fn );
+
+			( *recurser )( );
+		};
+
+		return q::make_promise( get_queue( ), std::move( cb ) );
+	}
+
 	template< typename Promise, bool Shared = Promise::shared_type::value >
 	typename std::enable_if<
 		!Shared,
@@ -1498,6 +1912,24 @@ public:
 		) ) );
 	}
 
+	/**
+	 * Writes a value once the channel has room for it, and resolves to
+	 * true when it's accepted, or false if the channel gets closed. Unlike
+	 * write( ), multiple producers can await room this way, and they are
+	 * admitted in FIFO order, see shared_channel::write_async( ).
+	 */
+	template< typename... Args >
+	Q_NODISCARD
+	typename std::enable_if<
+		std::is_constructible< tuple_type, Args&&... >::value,
+		promise< bool >
+	>::type
+	write_async( Args&&... args )
+	{
+		return shared_channel_->write_async(
+			tuple_type( std::forward< Args >( args )... ) );
+	}
+
 	/**
 	 * Like write() but throws q::channel_closed_exception if the channel
 	 * was closed.
@@ -1645,6 +2077,17 @@ public:
 		return shared_channel_->get_queue( );
 	}
 
+	/**
+	 * Accounts the values buffered in this channel in @c budget (which can
+	 * be shared by many channels), using memory_size< T > for the size of
+	 * the values. Writers are asked to hold back while the budget is
+	 * exhausted, just like when the channel is full.
+	 */
+	void set_memory_budget( std::shared_ptr< memory_budget > budget )
+	{
+		shared_channel_->set_memory_budget( std::move( budget ) );
+	}
+
 private:
 	std::shared_ptr< detail::shared_channel< T... > > shared_channel_;
 	readable< T... > readable_;
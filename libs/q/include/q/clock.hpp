@@ -0,0 +1,91 @@
+/*
+ * Copyright 2016 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_CLOCK_HPP
+#define LIBQ_CLOCK_HPP
+
+#include <chrono>
+
+namespace q {
+
+/**
+ * The clock used for all timers in q. It is monotonic, so timers are
+ * unaffected by wall-clock adjustments.
+ */
+typedef std::chrono::steady_clock steady_clock;
+
+/**
+ * A monotonic clock which is cheaper to read than steady_clock, but with a
+ * lower resolution (typically 1-4ms). On Linux, this is CLOCK_MONOTONIC_COARSE.
+ * Other platforms fall back to steady_clock.
+ *
+ * It shares epoch and time_point type with steady_clock, so its time points
+ * can be compared with those of timers.
+ */
+struct coarse_clock
+{
+	typedef steady_clock::duration   duration;
+	typedef duration::rep            rep;
+	typedef duration::period         period;
+	typedef steady_clock::time_point time_point;
+
+	static constexpr bool is_steady = true;
+
+	static time_point now( ) noexcept;
+
+	/**
+	 * The resolution of this clock. As it's updated on timer ticks, now()
+	 * can lag behind steady_clock::now( ) by somewhat more than this, but
+	 * not by twice as much.
+	 */
+	static duration resolution( ) noexcept;
+};
+
+/**
+ * A clock reading the CPU time-stamp counter, for tracing and measuring short
+ * durations cheaply. The counter is calibrated against steady_clock the first
+ * time the clock is used. The epoch is unspecified, so time points can only be
+ * compared with each other.
+ *
+ * On platforms without an (invariant) time-stamp counter, this falls back to
+ * steady_clock.
+ */
+struct tsc_clock
+{
+	typedef std::chrono::nanoseconds             duration;
+	typedef duration::rep                        rep;
+	typedef duration::period                     period;
+	typedef std::chrono::time_point< tsc_clock > time_point;
+
+	static constexpr bool is_steady = true;
+
+	static time_point now( ) noexcept;
+
+	/**
+	 * Whether this clock is backed by the time-stamp counter or not.
+	 */
+	static bool is_native( ) noexcept;
+};
+
+/**
+ * Returns the current time from the cheapest clock which lags behind
+ * steady_clock by at most @c accuracy.
+ */
+steady_clock::time_point now_within( steady_clock::duration accuracy ) noexcept;
+
+} // namespace q
+
+#endif // LIBQ_CLOCK_HPP
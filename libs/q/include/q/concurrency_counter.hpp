@@ -20,6 +20,7 @@
 #include <q/concurrency.hpp>
 #include <q/promise.hpp>
 #include <q/mutex.hpp>
+#include <q/detail/stress.hpp>
 
 namespace q {
 
@@ -77,6 +78,8 @@ public:
 			--value_;
 		}
 
+		Q_STRESS_POINT( "concurrency_counter::dec" );
+
 		if ( _continuation )
 			_continuation->defer_->set_value( );
 
@@ -100,6 +103,8 @@ public:
 
 	promise< > get_promise( )
 	{
+		Q_STRESS_POINT( "concurrency_counter::get_promise" );
+
 		Q_AUTO_UNIQUE_LOCK( mut_ );
 
 		if ( value_ < limit_ )
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2017 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_CONTEXT_HPP
+#define LIBQ_CONTEXT_HPP
+
+#include <q/types.hpp>
+
+#include <memory>
+
+namespace q {
+
+class context;
+typedef std::shared_ptr< const context > context_ptr;
+
+/**
+ * A context is an immutable set of values, such as a request id, a deadline or
+ * a tenant, which follows a chain of asynchronous tasks without being passed
+ * explicitly to each of them.
+ *
+ * The context of the current thread is captured when a continuation is
+ * registered on a promise (e.g. with then( ) or fail( )) and when a task is
+ * scheduled with q::async or q::make_promise. It is then restored while that
+ * continuation or task runs, on whichever thread runs it, so that everything
+ * scheduled from within it inherits the same context.
+ *
+ * Capturing costs one shared pointer copy per task, and only when a context is
+ * set; tasks scheduled without a context are left untouched.
+ *
+ * Values are read and set using context_slot and context_scope:
+ *
+ *   static q::context_slot< std::string > request_id;
+ *
+ *   q::context_scope scope( request_id, "abc" );
+ *   q::with( queue )
+ *   .then( [ ]( )
+ *   {
+ *       // *request_id.get( ) == "abc"
+ *   } );
+ */
+class context
+{
+public:
+	/**
+	 * The context of the current thread, or nullptr if none is set.
+	 */
+	static const context_ptr& current( ) noexcept;
+
+	/**
+	 * Finds the value of the slot identified by @c key, in this context or
+	 * in any of its ancestors, or nullptr if it isn't set.
+	 */
+	const void* find( const void* key ) const noexcept;
+
+	const context_ptr& parent( ) const noexcept
+	{
+		return parent_;
+	}
+
+protected:
+	context( context_ptr parent, const void* key, const void* value )
+	: parent_( std::move( parent ) )
+	, key_( key )
+	, value_( value )
+	{ }
+
+private:
+	context_ptr parent_;
+	const void* key_;
+	const void* value_;
+};
+
+namespace detail {
+
+template< typename T >
+class context_node
+: public context
+{
+public:
+	context_node( context_ptr parent, const void* key, T&& value )
+	: context( std::move( parent ), key, &value_ )
+	, value_( std::move( value ) )
+	{ }
+
+private:
+	const T value_;
+};
+
+/**
+ * Wraps @c fn so that it runs within the context of the current thread (as of
+ * this call). Returns @c fn as is if there is no current context.
+ */
+task with_current_context( task&& fn );
+
+} // namespace detail
+
+/**
+ * A typed key of a value in a context. Slots are identified by their address,
+ * so they should be static (or otherwise outlive the contexts using them).
+ */
+template< typename T >
+class context_slot
+{
+public:
+	context_slot( ) = default;
+
+	context_slot( const context_slot& ) = delete;
+	context_slot& operator=( const context_slot& ) = delete;
+
+	/**
+	 * The value of this slot in the current context, or nullptr if unset.
+	 */
+	const T* get( ) const noexcept
+	{
+		auto& ctx = context::current( );
+
+		if ( !ctx )
+			return nullptr;
+
+		return static_cast< const T* >( ctx->find( this ) );
+	}
+
+	/**
+	 * The value of this slot in the current context, or @c fallback.
+	 */
+	T get_or( T fallback ) const
+	{
+		auto value = get( );
+
+		return value ? *value : std::move( fallback );
+	}
+};
+
+/**
+ * Sets the current context while in scope, and restores the previous one when
+ * destructed. Either sets a value of a slot (on top of the current context),
+ * or installs a previously captured context as a whole.
+ */
+class context_scope
+{
+public:
+	explicit context_scope( context_ptr ctx ) noexcept;
+
+	template< typename T >
+	context_scope( const context_slot< T >& slot, T value )
+	: context_scope( std::make_shared< detail::context_node< T > >(
+		context::current( ), &slot, std::move( value ) ) )
+	{ }
+
+	~context_scope( );
+
+	context_scope( const context_scope& ) = delete;
+	context_scope& operator=( const context_scope& ) = delete;
+
+private:
+	context_ptr previous_;
+};
+
+} // namespace q
+
+#endif // LIBQ_CONTEXT_HPP
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2017 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_CREDIT_HPP
+#define LIBQ_CREDIT_HPP
+
+#include <q/channel.hpp>
+#include <q/temporarily_copyable.hpp>
+
+namespace q {
+
+class credit_pool;
+
+/**
+ * A credit is the right for one item to be in flight in a pipeline. It is
+ * returned to its credit_pool when destructed (or released), which is
+ * typically when the last stage of the pipeline is done with the item.
+ */
+class credit
+{
+public:
+	credit( );
+	credit( credit&& );
+	credit( const credit& ) = delete;
+	~credit( );
+
+	credit& operator=( credit&& );
+	credit& operator=( const credit& ) = delete;
+
+	explicit operator bool( ) const;
+
+	/**
+	 * Returns the credit to the pool.
+	 */
+	void release( );
+
+private:
+	friend class credit_pool;
+
+	credit( std::shared_ptr< credit_pool > pool );
+
+	std::shared_ptr< credit_pool > pool_;
+};
+
+/**
+ * A credit_pool bounds the number of items in flight through a whole
+ * pipeline, rather than per stage. Each stage of a channel pipeline buffers
+ * independently, so without this, the in-flight data (and the latency) of a
+ * pipeline is the sum of all its buffers.
+ *
+ * The source acquires a credit for every item, and the credit travels with
+ * the item through the pipeline, as the first value of every channel, e.g.
+ * channel< credit, T >. Stages move the credit along with their output, and
+ * when the sink is done with an item, the credit is destructed and returned,
+ * which lets the source produce the next item. Items which are dropped (e.g.
+ * filtered out, or cleared from a closed channel) return their credits too.
+ *
+ * Since the credits bound the pipeline, stages can write with write( ) without
+ * caring about should_write( ). A sink which completes asynchronously should
+ * keep the credit until it's done, e.g. by moving it into its continuation.
+ *
+ * Waiting acquisitions are granted in FIFO order.
+ */
+class credit_pool
+: public std::enable_shared_from_this< credit_pool >
+{
+public:
+	~credit_pool( );
+
+	static std::shared_ptr< credit_pool > construct( std::size_t credits );
+
+	/**
+	 * Changes the total number of credits. When lowered below the number
+	 * of credits in flight, no credits are granted until enough of them
+	 * have been returned.
+	 */
+	void set_credits( std::size_t credits );
+
+	/** The total number of credits */
+	std::size_t credits( ) const;
+
+	/** The number of credits currently acquired */
+	std::size_t in_flight( ) const;
+
+	/** The number of acquisitions waiting for a credit */
+	std::size_t waiting( ) const;
+
+	/**
+	 * Acquires a credit, waiting (asynchronously) until one is available.
+	 */
+	promise< credit > acquire( const queue_ptr& queue );
+
+	/**
+	 * Acquires a credit if one is available right now, otherwise returns
+	 * an empty credit.
+	 */
+	credit try_acquire( );
+
+	/**
+	 * Acquires a credit and writes it, followed by @c args, to @c sink.
+	 * Resolves to the result of the write, i.e. false if @c sink is
+	 * closed (in which case the credit is returned).
+	 */
+	template< typename... T, typename... Args >
+	promise< bool > write( writable< credit, T... > sink, Args&&... args );
+
+	/**
+	 * Feeds the values of @c source into @c sink, reading a value only
+	 * when a credit is available for it. This turns an ordinary channel
+	 * into the source of a credit-bounded pipeline.
+	 *
+	 * When @c source is closed, @c sink is closed (with the same error if
+	 * any). When @c sink is closed, @c source is closed. The returned
+	 * promise is resolved when feeding has ended, or rejected with the
+	 * error of @c source.
+	 */
+	template< typename... T >
+	promise< > feed( readable< T... > source, writable< credit, T... > sink );
+
+protected:
+	credit_pool( std::size_t credits );
+
+private:
+	friend class credit;
+
+	void release( );
+	void update( );
+
+	struct pimpl;
+	std::unique_ptr< pimpl > pimpl_;
+};
+
+template< typename... T, typename... Args >
+promise< bool >
+credit_pool::write( writable< credit, T... > sink, Args&&... args )
+{
+	auto values = std::make_tuple( std::forward< Args >( args )... );
+	Q_MOVE_INTO_MOVABLE( values );
+
+	return acquire( sink.get_queue( ) )
+	.then( [ sink, Q_MOVABLE_MOVE( values ) ]( credit c ) mutable
+	{
+		return sink.write( std::tuple_cat(
+			std::make_tuple( std::move( c ) ),
+			Q_MOVABLE_CONSUME( values ) ) );
+	} );
+}
+
+template< typename... T >
+promise< >
+credit_pool::feed( readable< T... > source, writable< credit, T... > sink )
+{
+	auto self = shared_from_this( );
+	auto queue = sink.get_queue( );
+
+	auto cb = [ self, source, sink, queue ](
+		resolver< > resolve, rejecter< > reject
+	)
+	mutable
+	{
+		typedef function< void( ) > recurser_type;
+		auto recurser = std::make_shared< recurser_type >( );
+
+		// The recurser only refers weakly to itself, to not form a
+		// cycle. It's kept alive by the pending acquisition or read.
+		std::weak_ptr< recurser_type > weak_recurser = recurser;
+
+		auto recurser_fn =
+			[ self, source, sink, queue, weak_recurser, resolve, reject ]
+			( )
+			mutable
+		{
+			auto recurser = weak_recurser.lock( );
+
+			if ( sink.is_closed( ) )
+			{
+				source.close( );
+				resolve( );
+				return;
+			}
+
+			self->acquire( queue )
+			.then( [ source, sink, recurser, resolve ]( credit c )
+			mutable
+			{
+				Q_MOVE_INTO_MOVABLE( c );
+
+				return source.read_optional( )
+				.then( [
+					source, sink, recurser, resolve,
+					Q_MOVABLE_MOVE( c )
+				]( optional< std::tuple< T... > >&& value )
+				mutable
+				{
+					if ( !value )
+					{
+						sink.close( );
+						resolve( );
+						return;
+					}
+
+					auto written = sink.write( std::tuple_cat(
+						std::make_tuple(
+							Q_MOVABLE_CONSUME( c ) ),
+						std::move( *value ) ) );
+
+					if ( !written )
+					{
+						source.close( );
+						resolve( );
+						return;
+					}
+
+					( *recurser )( );
+				} );
+			} )
+			.fail( [ source, sink, reject ]( std::exception_ptr e )
+			mutable
+			{
+				sink.close( e );
+				source.close( e );
+				reject( std::move( e ) );
+			} );
+		};
+
+		*recurser = std::move( recurser_fn );
+
+		( *recurser )( );
+	};
+
+	return q::make_promise( queue, std::move( cb ) );
+}
+
+} // namespace q
+
+#endif // LIBQ_CREDIT_HPP
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2017 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_DETAIL_STRESS_HPP
+#define LIBQ_DETAIL_STRESS_HPP
+
+/**
+ * Q_STRESS_POINT( name ) annotates a point in the concurrent internals of q
+ * where a different interleaving of threads is interesting, typically right
+ * after a lock is released and before the result of the critical section is
+ * acted upon.
+ *
+ * These points are empty unless LIBQ_STRESS_INJECTION is defined, which is
+ * only the case for the stress test build of q (q-stress). In that build,
+ * each point calls the hook installed by the stress harness, which injects
+ * yields and sleeps.
+ */
+
+#ifdef LIBQ_STRESS_INJECTION
+
+#include <atomic>
+
+namespace q { namespace detail {
+
+typedef void( *stress_hook_fn )( const char* point );
+
+inline std::atomic< stress_hook_fn >& stress_hook( ) noexcept
+{
+	static std::atomic< stress_hook_fn > hook( nullptr );
+	return hook;
+}
+
+inline void set_stress_hook( stress_hook_fn fn ) noexcept
+{
+	stress_hook( ).store( fn, std::memory_order_release );
+}
+
+inline void stress_point( const char* point ) noexcept
+{
+	auto fn = stress_hook( ).load( std::memory_order_acquire );
+	if ( fn )
+		fn( point );
+}
+
+} } // namespace detail, namespace q
+
+#	define Q_STRESS_POINT( name ) \
+		::q::detail::stress_point( name )
+
+#else
+
+#	define Q_STRESS_POINT( name ) \
+		do { } while ( false )
+
+#endif // LIBQ_STRESS_INJECTION
+
+#endif // LIBQ_DETAIL_STRESS_HPP
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2013 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_DISPATCHER_CONTROLLER_HPP
+#define LIBQ_DISPATCHER_CONTROLLER_HPP
+
+#include <q/execution_context.hpp>
+#include <q/event_dispatcher.hpp>
+#include <q/function.hpp>
+#include <q/timer.hpp>
+
+#include <memory>
+
+namespace q {
+
+/**
+ * A dispatcher_controller periodically samples a tunable event dispatcher
+ * (e.g. a threadpool) and adjusts its tunables within configured bounds.
+ *
+ * Every sample measures the queue wait time (by timing a probe task through
+ * the queue), the worker utilization and the number of wake-ups per task. It:
+ *   * activates more threads when tasks wait too long or the workers are
+ *     saturated, and parks threads when they are mostly idle,
+ *   * increases the batch size when tasks wait too long, and decreases it
+ *     when they don't, to keep fairness,
+ *   * increases the spin window when most tasks need a thread to be woken
+ *     up, and decreases it when few do.
+ *
+ * Each decision is handed to an optional metrics function.
+ */
+class dispatcher_controller
+: public std::enable_shared_from_this< dispatcher_controller >
+{
+public:
+	struct bounds
+	{
+		bounds( );
+
+		/** Thread bounds, where a max of 0 means all threads */
+		std::size_t min_threads;
+		std::size_t max_threads;
+
+		std::size_t min_batch_size;
+		std::size_t max_batch_size;
+
+		timer::duration_type max_spin;
+
+		/** The queue wait time considered acceptable */
+		timer::duration_type target_wait;
+
+		/** Utilization (0 - 1) under/over which threads are parked/added */
+		double low_utilization;
+		double high_utilization;
+
+		/** How often to sample when started */
+		timer::duration_type interval;
+	};
+
+	struct decision
+	{
+		timer::point_type time;
+
+		/** The queue wait time of the latest probe */
+		timer::duration_type wait;
+
+		/** The busy ratio of the active threads since the last sample */
+		double utilization;
+
+		double wakeups_per_task;
+
+		/** Tasks per second since the last sample */
+		double throughput;
+
+		dispatcher_tunables previous;
+		dispatcher_tunables tunables;
+	};
+
+	typedef q::function< void( const decision& ) > metrics_function;
+
+	static std::shared_ptr< dispatcher_controller >
+	construct( std::shared_ptr< tunable_event_dispatcher > dispatcher,
+	           const queue_ptr& queue,
+	           const queue_ptr& control_queue,
+	           bounds limits = bounds( ),
+	           metrics_function metrics = nullptr );
+
+	/**
+	 * Constructs a controller for the dispatcher of an execution context,
+	 * probing the queue of the context.
+	 */
+	template< typename Dispatcher >
+	static std::shared_ptr< dispatcher_controller >
+	construct( const specific_execution_context_ptr< Dispatcher >& ctx,
+	           const queue_ptr& control_queue,
+	           bounds limits = bounds( ),
+	           metrics_function metrics = nullptr )
+	{
+		return construct(
+			ctx->dispatcher( ),
+			ctx->queue( ),
+			control_queue,
+			std::move( limits ),
+			std::move( metrics ) );
+	}
+
+	~dispatcher_controller( );
+
+	/**
+	 * Starts sampling periodically (by the configured interval) on the
+	 * control queue, until stopped or destructed.
+	 */
+	void start( );
+	void stop( );
+
+	/**
+	 * Samples the dispatcher and adjusts its tunables once. This is what
+	 * is run periodically when started, but can also be called manually.
+	 */
+	decision sample( );
+
+	decision last_decision( ) const;
+
+protected:
+	dispatcher_controller(
+		std::shared_ptr< tunable_event_dispatcher > dispatcher,
+		const queue_ptr& queue,
+		const queue_ptr& control_queue,
+		bounds limits,
+		metrics_function metrics );
+
+private:
+	void schedule( );
+	void probe( );
+
+	struct pimpl;
+	std::unique_ptr< pimpl > pimpl_;
+};
+
+} // namespace q
+
+#endif // LIBQ_DISPATCHER_CONTROLLER_HPP
@@ -22,6 +22,7 @@
 #include <q/async_termination.hpp>
 #include <q/expect.hpp>
 #include <q/function.hpp>
+#include <q/timer.hpp>
 
 #include <memory>
 
@@ -91,6 +92,82 @@ protected:
 	{ }
 };
 
+/**
+ * The run-time tunables of an event dispatcher, which can be adjusted while it
+ * is running, e.g. by a dispatcher_controller.
+ */
+struct dispatcher_tunables
+{
+	dispatcher_tunables( )
+	: active_threads( 1 )
+	, batch_size( 1 )
+	, spin( timer::duration_type::zero( ) )
+	{ }
+
+	/** The number of threads allowed to run tasks, the rest are parked */
+	std::size_t active_threads;
+
+	/** The max number of tasks fetched at once, before running them */
+	std::size_t batch_size;
+
+	/** For how long an idle thread polls for tasks before going to sleep */
+	timer::duration_type spin;
+};
+
+/**
+ * Accumulated counters of an event dispatcher. They are never reset, so the
+ * difference between two samples gives the rates in between.
+ */
+struct dispatcher_statistics
+{
+	dispatcher_statistics( )
+	: tasks( 0 )
+	, wakeups( 0 )
+	, timer_wakeups( 0 )
+	, busy( timer::duration_type::zero( ) )
+	{ }
+
+	/** The number of tasks run */
+	std::size_t tasks;
+
+	/** The number of times a sleeping thread was woken up */
+	std::size_t wakeups;
+
+	/**
+	 * The number of those wake-ups caused by a timer expiring. With timer
+	 * slack, multiple timers can share one wake-up.
+	 */
+	std::size_t timer_wakeups;
+
+	/** The total time spent running tasks, summed over all threads */
+	timer::duration_type busy;
+};
+
+class tunable_event_dispatcher
+{
+public:
+	virtual dispatcher_tunables tunables( ) const = 0;
+
+	/**
+	 * Sets new tunables. Values out of range (e.g. more active threads
+	 * than there are threads) are clamped.
+	 */
+	virtual void set_tunables( const dispatcher_tunables& ) = 0;
+
+	/**
+	 * Enables or disables measuring the time spent running tasks, which
+	 * is disabled by default as it requires reading the clock. Task and
+	 * wake-up counters are always collected.
+	 */
+	virtual void collect_statistics( bool enable ) = 0;
+
+	virtual dispatcher_statistics statistics( ) const = 0;
+
+protected:
+	tunable_event_dispatcher( )
+	{ }
+};
+
 enum class termination
 {
 	/** Wait for backlog to empty out, and allow more tasks while doing so
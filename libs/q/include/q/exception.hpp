@@ -19,5 +19,6 @@
 
 #include <q/exception/exception.hpp>
 #include <q/exception/exception_errno.hpp>
+#include <q/exception/cached.hpp>
 
 #endif // LIBQ_EXCEPTION_HPP
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2017 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_EXCEPTION_CACHED_HPP
+#define LIBQ_EXCEPTION_CACHED_HPP
+
+#include <exception>
+#include <atomic>
+#include <utility>
+#include <type_traits>
+#include <stdexcept>
+
+namespace q {
+
+namespace detail {
+
+template< typename E >
+std::atomic< const std::exception_ptr* >& cached_exception_slot( ) noexcept
+{
+	static std::atomic< const std::exception_ptr* > slot( nullptr );
+	return slot;
+}
+
+/**
+ * Installs @c e as the cached exception of type E, unless one is already
+ * installed, and returns the installed one. The exception_ptr is never
+ * destructed, so it can be handed out during static destruction too.
+ */
+template< typename E >
+const std::exception_ptr& install_cached_exception(
+	std::exception_ptr&& e, bool* installed = nullptr )
+{
+	auto& slot = cached_exception_slot< E >( );
+
+	const std::exception_ptr* expected = nullptr;
+	auto ptr = new std::exception_ptr( std::move( e ) );
+
+	bool success = slot.compare_exchange_strong(
+		expected, ptr, std::memory_order_acq_rel );
+
+	if ( installed )
+		*installed = success;
+
+	if ( success )
+		return *ptr;
+
+	delete ptr;
+	return *expected;
+}
+
+template< typename E >
+typename std::enable_if<
+	std::is_default_constructible< E >::value,
+	std::exception_ptr
+>::type
+make_default_exception( )
+{
+	return std::make_exception_ptr( E( ) );
+}
+
+template< typename E >
+typename std::enable_if<
+	!std::is_default_constructible< E >::value,
+	std::exception_ptr
+>::type
+make_default_exception( )
+{
+	throw std::logic_error(
+		"cached_exception of an unregistered exception type which "
+		"isn't default constructible" );
+}
+
+} // namespace detail
+
+/**
+ * Returns a process-wide std::exception_ptr of an exception of type E.
+ *
+ * The exception is created once (default-constructed on first use, unless
+ * registered with register_cached_exception( )) and then handed out without
+ * any allocation or stacktrace capture. This is meant for rejections which are
+ * frequent and carry no data, like channel_closed_exception for every read of
+ * a closed channel, which would otherwise hammer the allocator during e.g. a
+ * shutdown.
+ *
+ * The exception object is shared, so it must be treated as immutable, i.e. no
+ * properties can be added to it once it's caught.
+ *
+ * Exception types which aren't default constructible must be registered
+ * before they are used, or std::logic_error is thrown.
+ */
+template< typename E >
+const std::exception_ptr& cached_exception( )
+{
+	auto ptr = detail::cached_exception_slot< E >( )
+		.load( std::memory_order_acquire );
+
+	if ( ptr )
+		return *ptr;
+
+	return detail::install_cached_exception< E >(
+		detail::make_default_exception< E >( ) );
+}
+
+/**
+ * Registers @c e as the cached exception of its type, to be returned by
+ * cached_exception< E >( ), e.g. for exceptions which aren't default
+ * constructible or to create them up-front at startup. Returns false if an
+ * exception of this type was already cached (by an earlier registration or
+ * use), in which case that one is kept.
+ */
+template< typename E >
+bool register_cached_exception( E&& e )
+{
+	typedef typename std::decay< E >::type exception_type;
+
+	bool installed;
+
+	detail::install_cached_exception< exception_type >(
+		std::make_exception_ptr( std::forward< E >( e ) ), &installed );
+
+	return installed;
+}
+
+} // namespace q
+
+#endif // LIBQ_EXCEPTION_CACHED_HPP
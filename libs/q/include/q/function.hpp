@@ -20,6 +20,8 @@
 #include <q/pp.hpp>
 #include <q/functional.hpp>
 
+#include <stdexcept>
+
 #ifdef LIBQ_ON_WINDOWS
 #	pragma warning( push )
 #	pragma warning( disable : 4521 )
@@ -17,7 +17,6 @@
 #ifndef LIBQ_FUNCTIONAL_HPP
 #define LIBQ_FUNCTIONAL_HPP
 
-#include <iostream>
 #include <functional>
 
 #include <q/pp.hpp>
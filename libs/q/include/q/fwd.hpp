@@ -0,0 +1,79 @@
+/*
+ * Copyright 2017 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_FWD_HPP
+#define LIBQ_FWD_HPP
+
+#include <memory>
+
+/**
+ * Forward declarations of the common q types. Include this instead of the
+ * full headers (such as <q/promise.hpp>) in headers which only name these
+ * types, e.g. in function declarations, to keep the compilation of their
+ * users cheap.
+ */
+
+namespace q {
+
+template< typename... T >
+class promise;
+
+template< typename... T >
+class shared_promise;
+
+template< typename... T >
+class readable;
+
+template< typename... T >
+class writable;
+
+template< typename... T >
+class channel;
+
+class byte_block;
+
+class scope;
+
+class queue;
+typedef std::shared_ptr< queue > queue_ptr;
+
+class scheduler;
+
+class basic_event_dispatcher;
+class blocking_dispatcher;
+class threadpool;
+
+class execution_context;
+typedef std::shared_ptr< execution_context > execution_context_ptr;
+
+template< typename Dispatcher >
+class specific_execution_context;
+
+template< typename Dispatcher >
+using specific_execution_context_ptr =
+	std::shared_ptr< specific_execution_context< Dispatcher > >;
+
+class memory_budget;
+
+class credit;
+class credit_pool;
+
+class context;
+typedef std::shared_ptr< const context > context_ptr;
+
+} // namespace q
+
+#endif // LIBQ_FWD_HPP
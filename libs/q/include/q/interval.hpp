@@ -0,0 +1,189 @@
+/*
+ * Copyright 2016 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_INTERVAL_HPP
+#define LIBQ_INTERVAL_HPP
+
+#include <q/channel.hpp>
+#include <q/scope.hpp>
+#include <q/timer.hpp>
+
+namespace q {
+
+/**
+ * How a periodic timer handles ticks which are missed, e.g. when the queue is
+ * busy and the timer task runs late.
+ */
+enum class tick_policy
+{
+	/** Fire all missed ticks at once, so that no tick is lost */
+	catch_up,
+
+	/** Fire once for all missed ticks, and continue on the next period */
+	skip
+};
+
+namespace detail {
+
+/**
+ * A periodic_timer is the single timer entry of an interval or a periodic
+ * function. Each tick, it pushes a tiny timed task (referencing itself) to the
+ * queue. The next tick time is always advanced by whole periods from the
+ * start, so it doesn't drift with the time it takes to run the ticks.
+ */
+class periodic_timer
+: public std::enable_shared_from_this< periodic_timer >
+{
+public:
+	/**
+	 * The tick function is called with the scheduled time of the tick, and
+	 * returns false to stop the timer.
+	 */
+	typedef q::unique_function< bool( timer::point_type ) > tick_function;
+
+	static std::shared_ptr< periodic_timer >
+	construct( const queue_ptr& queue,
+	           timer::duration_type period,
+	           tick_policy policy,
+	           tick_function fn );
+
+	~periodic_timer( );
+
+	/**
+	 * Starts the timer, with the first tick one period from now.
+	 */
+	void start( );
+
+	/**
+	 * Stops the timer. A tick which is currently running will finish.
+	 */
+	void stop( );
+
+protected:
+	periodic_timer( const queue_ptr& queue,
+	                timer::duration_type period,
+	                tick_policy policy,
+	                tick_function fn );
+
+private:
+	void schedule( );
+	void fire( );
+
+	struct pimpl;
+	std::unique_ptr< pimpl > pimpl_;
+};
+
+} // namespace detail
+
+/**
+ * Returns a readable which gets the (scheduled) time of each tick, every
+ * @c period. The ticks are scheduled on @c queue.
+ *
+ * With tick_policy::skip, ticks are also skipped while the channel is full,
+ * i.e. when the reader doesn't keep up. Close the readable to stop the
+ * interval.
+ */
+inline readable< timer::point_type >
+interval( const queue_ptr& queue,
+          timer::duration_type period,
+          tick_policy policy = tick_policy::skip,
+          std::size_t buffer_count = 1 )
+{
+	channel< timer::point_type > ch( queue, buffer_count );
+	auto writable = ch.get_writable( );
+
+	auto timer = detail::periodic_timer::construct(
+		queue,
+		period,
+		policy,
+		[ writable, policy ]( timer::point_type tick ) mutable
+		{
+			if ( writable.is_closed( ) )
+				return false;
+
+			if (
+				policy == tick_policy::skip &&
+				!writable.should_write( )
+			)
+				return true;
+
+			return writable.write( tick );
+		}
+	);
+
+	timer->start( );
+
+	return ch.get_readable( );
+}
+
+/**
+ * Calls @c fn on @c queue every @c period, until the returned scope is
+ * destructed. @c fn can take the scheduled time of the tick as argument.
+ */
+template< typename Fn >
+typename std::enable_if<
+	Q_ARITY_OF( Fn ) == 1,
+	scope
+>::type
+periodic( const queue_ptr& queue,
+          timer::duration_type period,
+          Fn&& fn,
+          tick_policy policy = tick_policy::skip )
+{
+	Q_MAKE_MOVABLE( fn );
+
+	auto timer = detail::periodic_timer::construct(
+		queue,
+		period,
+		policy,
+		[ Q_MOVABLE_FORWARD( fn ) ]( timer::point_type tick ) mutable
+		{
+			Q_MOVABLE_GET( fn )( tick );
+			return true;
+		}
+	);
+
+	timer->start( );
+
+	return make_scoped_function( [ timer ]( )
+	{
+		timer->stop( );
+	} );
+}
+
+template< typename Fn >
+typename std::enable_if<
+	Q_ARITY_OF( Fn ) == 0,
+	scope
+>::type
+periodic( const queue_ptr& queue,
+          timer::duration_type period,
+          Fn&& fn,
+          tick_policy policy = tick_policy::skip )
+{
+	Q_MAKE_MOVABLE( fn );
+
+	return periodic( queue, period,
+		[ Q_MOVABLE_FORWARD( fn ) ]( timer::point_type ) mutable
+		{
+			Q_MOVABLE_GET( fn )( );
+		},
+		policy );
+}
+
+} // namespace q
+
+#endif // LIBQ_INTERVAL_HPP
@@ -23,7 +23,6 @@
 
 #include <q/detail/lib.hpp>
 
-#include <iostream>
 
 namespace q {
 
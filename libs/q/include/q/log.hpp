@@ -21,7 +21,7 @@
 
 #include <q/types.hpp>
 
-#include <iostream>
+#include <sstream>
 
 // TODO: We need some kind of way of visitor pattern where the entire logging
 // is done in the user application, rather than stringifying here.
@@ -196,13 +196,7 @@ struct perform_logging
 {
 	static void log( const macro_location& location,
 	                 const std::unique_ptr< logtype_adapter >& adapter,
-	                 const std::string& msg )
-	{
-		std::cout
-			<< adapter->string( ) << " "
-			<< location.string( ) << ": "
-			<< msg;
-	}
+	                 const std::string& msg );
 };
 
 } // namespace detail
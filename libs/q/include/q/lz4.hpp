@@ -0,0 +1,165 @@
+/*
+ * Copyright 2017 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_LZ4_HPP
+#define LIBQ_LZ4_HPP
+
+#include <q/block.hpp>
+#include <q/channel.hpp>
+#include <q/promise/async.hpp>
+
+#include <vector>
+#include <cstdint>
+
+/**
+ * An in-tree implementation of the LZ4 block format, to compress streams of
+ * byte_blocks without any external dependency.
+ *
+ * The raw functions produce and consume plain LZ4 blocks, compatible with any
+ * other LZ4 implementation. As LZ4 blocks don't record their uncompressed
+ * size, the byte_block functions prefix each block with its uncompressed size
+ * as a 32 bit little endian integer (like e.g. lz4.block in Python, with
+ * store_size).
+ */
+namespace q { namespace lz4 {
+
+Q_MAKE_SIMPLE_EXCEPTION( corrupt_data_exception );
+
+/**
+ * The largest uncompressed size of a block (as in the reference LZ4).
+ */
+constexpr std::size_t max_block_size = 0x7E000000;
+
+/**
+ * The worst case compressed size of @c size bytes.
+ */
+constexpr std::size_t compress_bound( std::size_t size )
+{
+	return size + size / 255 + 16;
+}
+
+/**
+ * Compresses @c size bytes from @c src into @c dst as an LZ4 block, and
+ * returns the compressed size. @c capacity must be at least
+ * compress_bound( size ), or std::out_of_range is thrown.
+ */
+std::size_t compress(
+	const std::uint8_t* src, std::size_t size,
+	std::uint8_t* dst, std::size_t capacity );
+
+/**
+ * Decompresses the LZ4 block of @c size bytes at @c src into @c dst, and
+ * returns the decompressed size. Throws corrupt_data_exception if the block is
+ * malformed or doesn't fit in @c capacity bytes.
+ */
+std::size_t decompress(
+	const std::uint8_t* src, std::size_t size,
+	std::uint8_t* dst, std::size_t capacity );
+
+/**
+ * Compresses a block into a size-prefixed LZ4 block. The output is a slice of
+ * a pooled buffer, which is reused once all slices of it are destructed.
+ */
+byte_block compress( const byte_block& block );
+
+/**
+ * Compresses a chain of blocks, as if they were one contiguous block.
+ */
+byte_block compress( const std::vector< byte_block >& blocks );
+
+/**
+ * Decompresses a size-prefixed LZ4 block, into a pooled buffer.
+ */
+byte_block decompress( const byte_block& block );
+
+namespace detail {
+
+template< typename Fn >
+readable< byte_block >
+transform( readable< byte_block > source, queue_ptr queue, Fn fn )
+{
+	channel< byte_block > ch(
+		source.get_queue( ), std::max< std::size_t >(
+			source.buffer_count( ), 1 ) );
+
+	auto writable = ch.get_writable( );
+
+	auto on_block = [ writable, queue, fn ]( byte_block&& block )
+	mutable -> promise< >
+	{
+		return q::async( queue, fn, std::move( block ) )
+		.then( [ writable ]( byte_block&& out ) mutable
+		{
+			return writable.write_async( std::move( out ) );
+		} )
+		.then( [ ]( bool written )
+		{
+			if ( !written )
+				Q_THROW( channel_closed_exception( ) );
+		} );
+	};
+
+	source.consume( on_block )
+	.then( [ writable ]( ) mutable
+	{
+		writable.close( );
+	} )
+	.fail( [ writable ]( std::exception_ptr e ) mutable
+	{
+		writable.close( e );
+	} );
+
+	return ch.get_readable( );
+}
+
+} // namespace detail
+
+/**
+ * Returns a readable of the blocks of @c source compressed (one by one, in
+ * order) on @c queue, e.g. the queue of a threadpool. Closing (or an error of)
+ * either end propagates to the other.
+ */
+inline readable< byte_block >
+compress( readable< byte_block > source, queue_ptr queue )
+{
+	return detail::transform(
+		std::move( source ),
+		std::move( queue ),
+		[ ]( byte_block&& block )
+		{
+			return compress( block );
+		} );
+}
+
+/**
+ * Returns a readable of the blocks of @c source decompressed on @c queue. A
+ * corrupt block closes both ends with corrupt_data_exception.
+ */
+inline readable< byte_block >
+decompress( readable< byte_block > source, queue_ptr queue )
+{
+	return detail::transform(
+		std::move( source ),
+		std::move( queue ),
+		[ ]( byte_block&& block )
+		{
+			return decompress( block );
+		} );
+}
+
+} } // namespace lz4, namespace q
+
+#endif // LIBQ_LZ4_HPP
@@ -0,0 +1,232 @@
+/*
+ * Copyright 2016 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_MEMORY_BUDGET_HPP
+#define LIBQ_MEMORY_BUDGET_HPP
+
+#include <q/promise.hpp>
+#include <q/block.hpp>
+
+#include <string>
+#include <vector>
+#include <limits>
+
+namespace q {
+
+class memory_budget;
+
+/**
+ * A memory_reservation is a number of bytes reserved from a memory_budget. The
+ * bytes are returned to the budget when the reservation is destructed (or
+ * released).
+ */
+class memory_reservation
+{
+public:
+	memory_reservation( );
+	memory_reservation( memory_reservation&& );
+	memory_reservation( const memory_reservation& ) = delete;
+	~memory_reservation( );
+
+	memory_reservation& operator=( memory_reservation&& );
+	memory_reservation& operator=( const memory_reservation& ) = delete;
+
+	std::size_t bytes( ) const;
+
+	explicit operator bool( ) const;
+
+	/**
+	 * Returns the reserved bytes to the budget.
+	 */
+	void release( );
+
+private:
+	friend class memory_budget;
+
+	memory_reservation(
+		std::shared_ptr< memory_budget > budget, std::size_t bytes );
+
+	std::shared_ptr< memory_budget > budget_;
+	std::size_t bytes_;
+};
+
+/**
+ * A memory_budget limits the amount of in-flight data (e.g. buffered in
+ * channels) across producers. Producers reserve bytes, and wait when the
+ * budget is exhausted, which applies memory pressure back to the sources
+ * rather than letting buffers grow.
+ *
+ * Waiting reservations are granted in FIFO order. A reservation larger than
+ * the limit is granted when nothing else is reserved.
+ *
+ * memory_budget::global( ) is a process-wide budget, which is unlimited until
+ * set_limit( ) is called on it.
+ */
+class memory_budget
+: public std::enable_shared_from_this< memory_budget >
+{
+public:
+	typedef std::size_t listener_id;
+
+	static constexpr std::size_t unlimited =
+		std::numeric_limits< std::size_t >::max( );
+
+	~memory_budget( );
+
+	static std::shared_ptr< memory_budget > construct( std::size_t limit );
+
+	/**
+	 * The process-wide budget.
+	 */
+	static std::shared_ptr< memory_budget > global( );
+
+	void set_limit( std::size_t limit );
+
+	std::size_t limit( ) const;
+
+	/** The number of bytes currently reserved */
+	std::size_t used( ) const;
+
+	/** The number of reservations waiting for memory */
+	std::size_t waiting( ) const;
+
+	/**
+	 * Whether the budget is used up, i.e. producers should hold back.
+	 */
+	bool exhausted( ) const;
+
+	/**
+	 * Reserves @c bytes, waiting (asynchronously) until they are available.
+	 */
+	promise< memory_reservation >
+	reserve( const queue_ptr& queue, std::size_t bytes );
+
+	/**
+	 * Reserves @c bytes if available right now, otherwise returns an empty
+	 * reservation.
+	 */
+	memory_reservation try_reserve( std::size_t bytes );
+
+	/**
+	 * Reserves @c bytes even if that exceeds the limit. This is used to
+	 * account for data which already exists, such as values written to a
+	 * channel, and makes exhausted( ) true until memory is released.
+	 */
+	memory_reservation force_reserve( std::size_t bytes );
+
+	/**
+	 * Adds a function which is called when the budget goes from being
+	 * exhausted to not being exhausted. It is called without any locks
+	 * held, from the thread releasing the memory, so it should only
+	 * schedule work.
+	 */
+	listener_id add_listener( shared_task fn );
+	void remove_listener( listener_id id );
+
+protected:
+	memory_budget( std::size_t limit );
+
+private:
+	friend class memory_reservation;
+
+	void release( std::size_t bytes );
+	void update( std::size_t released, bool limit_changed );
+
+	struct pimpl;
+	std::unique_ptr< pimpl > pimpl_;
+};
+
+/**
+ * memory_size< T > tells how many bytes a value of type T holds, for memory
+ * budget accounting. Specialize it for types which own external memory.
+ */
+template< typename T >
+struct memory_size
+{
+	static std::size_t of( const T& )
+	{
+		return sizeof( T );
+	}
+};
+
+template< >
+struct memory_size< byte_block >
+{
+	static std::size_t of( const byte_block& block )
+	{
+		return block.size( );
+	}
+};
+
+template< >
+struct memory_size< std::string >
+{
+	static std::size_t of( const std::string& s )
+	{
+		return s.size( );
+	}
+};
+
+template< typename T, typename Allocator >
+struct memory_size< std::vector< T, Allocator > >
+{
+	static std::size_t of( const std::vector< T, Allocator >& v )
+	{
+		return v.size( ) * sizeof( T );
+	}
+};
+
+namespace detail {
+
+template< std::size_t I, typename Tuple >
+typename std::enable_if<
+	I == std::tuple_size< Tuple >::value,
+	std::size_t
+>::type
+tuple_memory_size( const Tuple& )
+{
+	return 0;
+}
+
+template< std::size_t I, typename Tuple >
+typename std::enable_if<
+	( I < std::tuple_size< Tuple >::value ),
+	std::size_t
+>::type
+tuple_memory_size( const Tuple& t )
+{
+	typedef typename std::decay<
+		typename std::tuple_element< I, Tuple >::type
+	>::type element_type;
+
+	return memory_size< element_type >::of( std::get< I >( t ) ) +
+		tuple_memory_size< I + 1 >( t );
+}
+
+} // namespace detail
+
+/**
+ * The memory size of all elements in a tuple.
+ */
+template< typename... T >
+std::size_t memory_size_of( const std::tuple< T... >& t )
+{
+	return detail::tuple_memory_size< 0 >( t );
+}
+
+} // namespace q
+
+#endif // LIBQ_MEMORY_BUDGET_HPP
@@ -0,0 +1,188 @@
+/*
+ * Copyright 2017 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_OPTIONAL_HPP
+#define LIBQ_OPTIONAL_HPP
+
+#include <q/exception.hpp>
+
+#include <type_traits>
+#include <utility>
+#include <new>
+
+namespace q {
+
+Q_MAKE_SIMPLE_EXCEPTION( bad_optional_access );
+
+/**
+ * A value which may or may not be set, like std::optional (which isn't
+ * available in C++11).
+ */
+template< typename T >
+class optional
+{
+public:
+	typedef T value_type;
+
+	optional( ) noexcept
+	: has_value_( false )
+	{ }
+
+	optional( const T& value )
+	: has_value_( false )
+	{
+		emplace( value );
+	}
+
+	optional( T&& value )
+	: has_value_( false )
+	{
+		emplace( std::move( value ) );
+	}
+
+	optional( const optional& other )
+	: has_value_( false )
+	{
+		if ( other.has_value_ )
+			emplace( *other );
+	}
+
+	optional( optional&& other )
+	noexcept( std::is_nothrow_move_constructible< T >::value )
+	: has_value_( false )
+	{
+		if ( other.has_value_ )
+			emplace( std::move( *other ) );
+	}
+
+	~optional( )
+	{
+		reset( );
+	}
+
+	optional& operator=( const optional& other )
+	{
+		if ( this != &other )
+		{
+			reset( );
+			if ( other.has_value_ )
+				emplace( *other );
+		}
+		return *this;
+	}
+
+	optional& operator=( optional&& other )
+	noexcept( std::is_nothrow_move_constructible< T >::value )
+	{
+		if ( this != &other )
+		{
+			reset( );
+			if ( other.has_value_ )
+				emplace( std::move( *other ) );
+		}
+		return *this;
+	}
+
+	template< typename... Args >
+	T& emplace( Args&&... args )
+	{
+		reset( );
+		::new ( &storage_ ) T( std::forward< Args >( args )... );
+		has_value_ = true;
+		return **this;
+	}
+
+	void reset( ) noexcept
+	{
+		if ( has_value_ )
+		{
+			( **this ).~T( );
+			has_value_ = false;
+		}
+	}
+
+	bool has_value( ) const noexcept
+	{
+		return has_value_;
+	}
+
+	explicit operator bool( ) const noexcept
+	{
+		return has_value_;
+	}
+
+	T& operator*( ) noexcept
+	{
+		return *reinterpret_cast< T* >( &storage_ );
+	}
+
+	const T& operator*( ) const noexcept
+	{
+		return *reinterpret_cast< const T* >( &storage_ );
+	}
+
+	T* operator->( ) noexcept
+	{
+		return &**this;
+	}
+
+	const T* operator->( ) const noexcept
+	{
+		return &**this;
+	}
+
+	/**
+	 * Returns the value, or throws bad_optional_access if there is none.
+	 */
+	T& value( )
+	{
+		if ( !has_value_ )
+			Q_THROW( bad_optional_access( ) );
+		return **this;
+	}
+
+	const T& value( ) const
+	{
+		if ( !has_value_ )
+			Q_THROW( bad_optional_access( ) );
+		return **this;
+	}
+
+	template< typename U >
+	T value_or( U&& fallback ) const
+	{
+		return has_value_
+			? **this
+			: static_cast< T >( std::forward< U >( fallback ) );
+	}
+
+private:
+	typename std::aligned_storage<
+		sizeof( T ), std::alignment_of< T >::value
+	>::type storage_;
+	bool has_value_;
+};
+
+template< typename T >
+optional< typename std::decay< T >::type > make_optional( T&& value )
+{
+	return optional< typename std::decay< T >::type >(
+		std::forward< T >( value ) );
+}
+
+} // namespace q
+
+#endif // LIBQ_OPTIONAL_HPP
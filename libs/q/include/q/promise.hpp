@@ -17,6 +17,7 @@
 #ifndef LIBQ_PROMISE_HPP
 #define LIBQ_PROMISE_HPP
 
+#include <q/context.hpp>
 #include <q/functional.hpp>
 #include <q/log.hpp>
 #include <q/temporarily_copyable.hpp>
@@ -38,13 +39,17 @@
 #include <q/promise/all.hpp>
 #include <q/promise/make.hpp>
 #include <q/promise/delay.hpp>
+#include <q/promise/async.hpp>
+#include <q/promise/yield.hpp>
 #include <q/promise/promisify.hpp>
+#include <q/promise/impl/observe.hpp>
 #include <q/promise/impl/then.hpp>
 #include <q/promise/impl/fail.hpp>
 #include <q/promise/impl/finally.hpp>
 #include <q/promise/impl/tap.hpp>
 #include <q/promise/impl/tap_error.hpp>
 #include <q/promise/impl/rest.hpp>
+#include <q/promise/extern.hpp>
 
 namespace q {
 
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2016 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_PROMISE_ASYNC_HPP
+#define LIBQ_PROMISE_ASYNC_HPP
+
+namespace q {
+
+namespace detail {
+
+template< typename Ret >
+struct async_defer
+{
+	typedef suitable_defer_t< Ret > type;
+};
+
+template< typename... T >
+struct async_defer< ::q::promise< T... > >
+{
+	typedef defer< T... > type;
+};
+
+template< typename... T >
+struct async_defer< ::q::shared_promise< T... > >
+{
+	typedef defer< T... > type;
+};
+
+/**
+ * An async_call is a defer fused with the function (and its arguments) which
+ * will resolve it. It is allocated once, and the task scheduled on the queue
+ * only holds a pointer to it.
+ */
+template< typename Fn, typename... Args >
+class async_call
+: public async_defer< result_of_t< Fn > >::type
+{
+public:
+	typedef result_of_t< Fn >                             result_type;
+	typedef typename async_defer< result_type >::type     defer_type;
+	typedef typename defer_type::expect_type              expect_type;
+	typedef typename defer_type::promise_type             promise_type;
+
+	template< typename Fn_, typename Tuple >
+	static std::shared_ptr< async_call >
+	create( const queue_ptr& queue, Fn_&& fn, Tuple&& args )
+	{
+		return defer_type::template construct_derived< async_call >(
+			queue,
+			std::forward< Fn_ >( fn ),
+			std::forward< Tuple >( args ) );
+	}
+
+	void run( )
+	{
+		auto& fn = fn_;
+		auto& args = args_;
+
+		this->set_by_fun( [ &fn, &args ]( ) -> result_type
+		{
+			return ::q::call_with_args_by_tuple(
+				std::move( fn ), std::move( args ) );
+		} );
+	}
+
+protected:
+	template< typename Fn_, typename Tuple >
+	async_call(
+		std::promise< expect_type >&& promise,
+		promise_signal_ptr&& signal,
+		promise_type&& deferred,
+		Fn_&& fn,
+		Tuple&& args
+	)
+	: defer_type(
+		std::move( promise ), std::move( signal ), std::move( deferred ) )
+	, fn_( std::forward< Fn_ >( fn ) )
+	, args_( std::forward< Tuple >( args ) )
+	{ }
+
+private:
+	Fn fn_;
+	std::tuple< Args... > args_;
+};
+
+template< typename Fn, typename... Args >
+using async_call_t = async_call<
+	typename std::decay< Fn >::type,
+	typename std::decay< Args >::type...
+>;
+
+} // namespace detail
+
+/**
+ * Schedules @c fn to be called with @c args on @c queue, and returns a promise
+ * of its result. If @c fn returns a promise, the returned promise will be
+ * resolved by it.
+ *
+ * The arguments are copied (or moved) and kept together with the function and
+ * the defer of the resulting promise, in one allocation.
+ */
+template< typename Fn, typename... Args >
+typename std::enable_if<
+	is_function_t< Fn >::value
+	and
+	Q_ARITY_OF( Fn ) == sizeof...( Args ),
+	typename detail::async_call_t< Fn, Args... >::promise_type
+>::type
+async( const queue_ptr& queue, Fn&& fn, Args&&... args )
+{
+	typedef detail::async_call_t< Fn, Args... > call_type;
+
+	auto call = call_type::create(
+		queue,
+		std::forward< Fn >( fn ),
+		std::tuple< typename std::decay< Args >::type... >(
+			std::forward< Args >( args )... ) );
+
+	auto promise = call->get_promise( );
+
+	queue->push( detail::with_current_context( [ call ]( ) mutable
+	{
+		call->run( );
+	} ) );
+
+	return promise;
+}
+
+} // namespace q
+
+#endif // LIBQ_PROMISE_ASYNC_HPP
@@ -17,20 +17,16 @@
 #ifndef LIBQ_PROMISE_CORE_HPP
 #define LIBQ_PROMISE_CORE_HPP
 
+#include <q/fwd.hpp>
 #include <q/exception.hpp>
 
 namespace q {
 
-template< typename... T >
-class promise;
-
-template< typename... T >
-class shared_promise;
-
 namespace detail {
 
 template< typename... T > class defer;
 template< bool, typename... > class generic_promise;
+template< bool, typename... > class observer_resolver;
 
 } // namespace detail
 
@@ -564,6 +564,19 @@ public:
 
 	static std::shared_ptr< defer< T... > >
 	construct( const queue_ptr& queue )
+	{
+		return construct_derived< defer< T... > >( queue );
+	}
+
+protected:
+	/**
+	 * Constructs a subclass of defer, which is then allocated together
+	 * with the defer itself. The subclass constructor gets the arguments
+	 * for the defer constructor, followed by @c args.
+	 */
+	template< typename Derived, typename... Args >
+	static std::shared_ptr< Derived >
+	construct_derived( const queue_ptr& queue, Args&&... args )
 	{
 		typedef typename state_data_type::future_type future_type;
 
@@ -577,13 +590,13 @@ public:
 
 		promise_type q_promise( std::move( state ), queue );
 
-		return ::q::make_shared_using_constructor< defer< T... > >(
+		return ::q::make_shared_using_constructor< Derived >(
 			std::move( std_promise ),
 			std::move( signal ),
-			std::move( q_promise ) );
+			std::move( q_promise ),
+			std::forward< Args >( args )... );
 	}
 
-protected:
 	defer( ) = delete;
 
 	defer( std::promise< expect_type >&& promise,
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2017 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_PROMISE_EXTERN_HPP
+#define LIBQ_PROMISE_EXTERN_HPP
+
+#include <q/block.hpp>
+
+#include <string>
+
+/**
+ * The promise classes of the most common types are explicitly instantiated in
+ * q, and declared extern here, so that users don't instantiate (and compile)
+ * their non-template members in every translation unit.
+ *
+ * Define LIBQ_NO_EXTERN_TEMPLATES to instantiate them implicitly anyway.
+ */
+
+#define LIBQ_PROMISE_INSTANTIATION_VOID( prefix ) \
+	prefix class ::q::detail::generic_promise< false >; \
+	prefix class ::q::detail::generic_promise< true >; \
+	prefix class ::q::promise< >; \
+	prefix class ::q::shared_promise< >;
+
+#define LIBQ_PROMISE_INSTANTIATION( prefix, T ) \
+	prefix class ::q::detail::generic_promise< false, T >; \
+	prefix class ::q::detail::generic_promise< true, T >; \
+	prefix class ::q::promise< T >; \
+	prefix class ::q::shared_promise< T >;
+
+#define LIBQ_PROMISE_INSTANTIATIONS( prefix ) \
+	LIBQ_PROMISE_INSTANTIATION_VOID( prefix ) \
+	LIBQ_PROMISE_INSTANTIATION( prefix, bool ) \
+	LIBQ_PROMISE_INSTANTIATION( prefix, int ) \
+	LIBQ_PROMISE_INSTANTIATION( prefix, std::size_t ) \
+	LIBQ_PROMISE_INSTANTIATION( prefix, std::string ) \
+	LIBQ_PROMISE_INSTANTIATION( prefix, ::q::byte_block )
+
+#ifndef LIBQ_NO_EXTERN_TEMPLATES
+
+LIBQ_PROMISE_INSTANTIATIONS( extern template )
+
+#endif // LIBQ_NO_EXTERN_TEMPLATES
+
+#endif // LIBQ_PROMISE_EXTERN_HPP
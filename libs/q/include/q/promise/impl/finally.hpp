@@ -37,34 +37,34 @@ typename std::enable_if<
 generic_promise< Shared, Args... >::
 finally( Fn&& fn, Queue&& queue )
 {
-	auto deferred = ::q::make_shared< detail::defer< Args... > >(
-	     is_set_default< Queue >::value
-	     ? ensure( set_default_get( queue ) )
-	     : get_queue( ) );
+	auto next_queue = is_set_default< Queue >::value
+		? ensure( set_default_get( queue ) )
+		: get_queue( );
 	Q_MAKE_MOVABLE( fn );
-	auto state = state_;
 
-	auto perform = [ deferred, Q_MOVABLE_FORWARD( fn ), state ]( ) mutable
+	auto observer = [ Q_MOVABLE_FORWARD( fn ) ](
+		const resolver_type& resolver
+	) mutable
 	{
-		auto value = state->consume( );
-
 		try
 		{
 			Q_MOVABLE_CONSUME( fn )( );
-
-			deferred->set_expect( std::move( value ) );
 		}
 		catch ( ... )
 		{
 			// TODO: Consider using a nested_exception
-			deferred->set_exception( std::current_exception( ) );
+			resolver.reject( std::current_exception( ) );
+			return;
 		}
-	};
 
-	state_->signal( )->push( std::move( perform ),
-	                         ensure( set_default_forward( queue ) ) );
+		resolver.resolve( );
+	};
 
-	return deferred->template get_suitable_promise< promise_this_type >( );
+	return observe< promise_this_type >(
+		std::move( observer ),
+		ensure( set_default_forward( queue ) ),
+		next_queue,
+		shared_type( ) );
 }
 
 /**
@@ -85,48 +85,41 @@ typename std::enable_if<
 generic_promise< Shared, Args...>::
 finally( Fn&& fn, Queue&& queue )
 {
-	auto deferred = ::q::make_shared< detail::defer< Args... > >(
-	     is_set_default< Queue >::value
-	     ? ensure( set_default_get( queue ) )
-	     : get_queue( ) );
+	auto next_queue = is_set_default< Queue >::value
+		? ensure( set_default_get( queue ) )
+		: get_queue( );
 	Q_MAKE_MOVABLE( fn );
-	auto state = state_;
 
-	auto perform = [ deferred, Q_MOVABLE_FORWARD( fn ), state ]( ) mutable
+	auto observer = [ Q_MOVABLE_FORWARD( fn ) ](
+		const resolver_type& resolver
+	) mutable
 	{
 		try
 		{
-			auto inner_promise = Q_MOVABLE_CONSUME( fn )( );
-
-			inner_promise
-			.then( [ deferred, state ]( )
+			Q_MOVABLE_CONSUME( fn )( )
+			.then( [ resolver ]( )
 			{
-				auto value = state->consume( );
-
-				deferred->set_expect( std::move( value ) );
+				resolver.resolve( );
 			} )
-			.fail( [ deferred, state ]( std::exception_ptr&& e )
+			.fail( [ resolver ]( std::exception_ptr&& e )
 			{
-				auto value = state->consume( );
-
 				// TODO: Consider using a nested_exception for
 				//       inner exceptions.
-				deferred->set_exception( std::move( e ) );
-
-				// deferred->set_expect( std::move( value ) );
+				resolver.reject( e );
 			} );
 		}
 		catch ( ... )
 		{
 			// TODO: Consider using a nested_exception
-			deferred->set_exception( std::current_exception( ) );
+			resolver.reject( std::current_exception( ) );
 		}
 	};
 
-	state_->signal( )->push( std::move( perform ),
-	                         ensure( set_default_forward( queue ) ) );
-
-	return deferred->get_promise( );
+	return observe< promise_this_type >(
+		std::move( observer ),
+		ensure( set_default_forward( queue ) ),
+		next_queue,
+		shared_type( ) );
 }
 
 } } // namespace detail, namespace q
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2016 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_PROMISE_PROMISE_IMPL_OBSERVE_HPP
+#define LIBQ_PROMISE_PROMISE_IMPL_OBSERVE_HPP
+
+namespace q { namespace detail {
+
+/**
+ * An observer_resolver is handed to observers (tap(), tap_error() and
+ * finally()), which, once done, either forward the observed value untouched
+ * with resolve(), or replace it with an exception with reject().
+ *
+ * For unique promises, the observed state is shared with the resulting
+ * promise, and resolving simply means signalling its continuations.
+ */
+template< typename... Args >
+class observer_resolver< false, Args... >
+{
+public:
+	typedef promise_state< std::tuple< Args... >, false > state_type;
+	typedef expect< std::tuple< Args... > >               expect_type;
+
+	observer_resolver(
+		std::shared_ptr< state_type > state, promise_signal_ptr signal
+	)
+	: state_( std::move( state ) )
+	, signal_( std::move( signal ) )
+	{ }
+
+	const expect_type& value( ) const
+	{
+		return state_->peek( );
+	}
+
+	void resolve( ) const
+	{
+		signal_->done( );
+	}
+
+	void reject( const std::exception_ptr& e ) const
+	{
+		state_->reject( e );
+		signal_->done( );
+	}
+
+private:
+	std::shared_ptr< state_type > state_;
+	promise_signal_ptr signal_;
+};
+
+/**
+ * For shared promises, the value cannot be shared with the resulting (unique)
+ * promise, so it is copied into it once the observer is done.
+ */
+template< typename... Args >
+class observer_resolver< true, Args... >
+{
+public:
+	typedef promise_state< std::tuple< Args... >, true > state_type;
+	typedef expect< std::tuple< Args... > >              expect_type;
+
+	observer_resolver(
+		std::shared_ptr< state_type > state,
+		std::shared_ptr< defer< Args... > > deferred
+	)
+	: state_( std::move( state ) )
+	, deferred_( std::move( deferred ) )
+	{ }
+
+	const expect_type& value( ) const
+	{
+		return state_->peek( );
+	}
+
+	void resolve( ) const
+	{
+		deferred_->set_expect( state_->consume( ) );
+	}
+
+	void reject( const std::exception_ptr& e ) const
+	{
+		deferred_->set_exception( e );
+	}
+
+private:
+	std::shared_ptr< state_type > state_;
+	std::shared_ptr< defer< Args... > > deferred_;
+};
+
+template< bool Shared, typename... Args >
+template< typename Promise, typename Observer >
+Promise
+generic_promise< Shared, Args... >::
+observe(
+	Observer&& observer,
+	const queue_ptr& queue,
+	const queue_ptr& next_queue,
+	std::false_type
+)
+{
+	auto signal = state_->observe( );
+	Q_MAKE_MOVABLE( observer );
+
+	resolver_type resolver( state_, state_->signal( ) );
+
+	auto perform = [ Q_MOVABLE_FORWARD( observer ), resolver ]( ) mutable
+	{
+		Q_MOVABLE_CONSUME( observer )( resolver );
+	};
+
+	signal->push( std::move( perform ), queue );
+
+	return Promise( this_type( state_, next_queue ) );
+}
+
+template< bool Shared, typename... Args >
+template< typename Promise, typename Observer >
+Promise
+generic_promise< Shared, Args... >::
+observe(
+	Observer&& observer,
+	const queue_ptr& queue,
+	const queue_ptr& next_queue,
+	std::true_type
+)
+{
+	auto deferred = detail::defer< Args... >::construct( next_queue );
+	Q_MAKE_MOVABLE( observer );
+
+	resolver_type resolver( state_, deferred );
+
+	auto perform = [ Q_MOVABLE_FORWARD( observer ), resolver ]( ) mutable
+	{
+		Q_MOVABLE_CONSUME( observer )( resolver );
+	};
+
+	state_->signal( )->push( std::move( perform ), queue );
+
+	return deferred->template get_suitable_promise< Promise >( );
+}
+
+} } // namespace detail, namespace q
+
+#endif // LIBQ_PROMISE_PROMISE_IMPL_OBSERVE_HPP
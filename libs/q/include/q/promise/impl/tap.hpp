@@ -40,21 +40,21 @@ typename std::enable_if<
 generic_promise< Shared, Args... >::
 tap( Fn&& fn, Queue&& queue )
 {
-	auto deferred = ::q::make_shared< detail::defer< Args... > >(
-	     is_set_default< Queue >::value
-	     ? ensure( set_default_get( queue ) )
-	     : get_queue( ) );
+	auto next_queue = is_set_default< Queue >::value
+		? ensure( set_default_get( queue ) )
+		: get_queue( );
 	Q_MAKE_MOVABLE( fn );
-	auto state = state_;
 
-	auto perform = [ deferred, Q_MOVABLE_FORWARD( fn ), state ]( ) mutable
+	auto observer = [ Q_MOVABLE_FORWARD( fn ) ](
+		const resolver_type& resolver
+	) mutable
 	{
-		auto value = state->consume( );
+		const tuple_expect_type& value = resolver.value( );
 
 		if ( value.has_exception( ) )
 		{
 			// Redirect exception
-			deferred->set_exception( value.exception( ) );
+			resolver.resolve( );
 			return;
 		}
 
@@ -64,19 +64,21 @@ tap( Fn&& fn, Queue&& queue )
 				Q_MOVABLE_CONSUME( fn ),
 				value.get( )
 			);
-
-			deferred->set_value( value.consume( ) );
 		}
 		catch ( ... )
 		{
-			deferred->set_exception( std::current_exception( ) );
+			resolver.reject( std::current_exception( ) );
+			return;
 		}
-	};
 
-	state_->signal( )->push( std::move( perform ),
-	                         ensure( set_default_forward( queue ) ) );
+		resolver.resolve( );
+	};
 
-	return std::move( deferred->get_promise( ) );
+	return observe< unique_this_type >(
+		std::move( observer ),
+		ensure( set_default_forward( queue ) ),
+		next_queue,
+		shared_type( ) );
 }
 
 /**
@@ -102,52 +104,49 @@ typename std::enable_if<
 generic_promise< Shared, Args...  >::
 tap( Fn&& fn, Queue&& queue )
 {
-	auto deferred = ::q::make_shared< detail::defer< Args... > >(
-	      is_set_default< Queue >::value
-	      ? ensure( set_default_get( queue ) )
-	      : get_queue( ) );
+	auto next_queue = is_set_default< Queue >::value
+		? ensure( set_default_get( queue ) )
+		: get_queue( );
 	Q_MAKE_MOVABLE( fn );
-	auto state = state_;
 
-	auto perform = [ deferred, Q_MOVABLE_FORWARD( fn ), state ]( ) mutable
+	auto observer = [ Q_MOVABLE_FORWARD( fn ) ](
+		const resolver_type& resolver
+	) mutable
 	{
-		auto value = state->consume( );
+		const tuple_expect_type& value = resolver.value( );
 
 		if ( value.has_exception( ) )
 		{
 			// Redirect exception
-			deferred->set_exception( value.exception( ) );
+			resolver.resolve( );
 			return;
 		}
 
 		try
 		{
-			auto shared_state = std::make_shared<
-				decltype( value )
-			>( std::move( value ) );
-
 			q::call_with_args_by_tuple(
-				Q_MOVABLE_CONSUME( fn ), shared_state->get( )
+				Q_MOVABLE_CONSUME( fn ), value.get( )
 			)
-			.then( [ deferred, shared_state ]( )
+			.then( [ resolver ]( )
 			{
-				deferred->set_value( shared_state->consume( ) );
+				resolver.resolve( );
 			} )
-			.fail( [ deferred ]( std::exception_ptr e )
+			.fail( [ resolver ]( std::exception_ptr e )
 			{
-				deferred->set_exception( e );
+				resolver.reject( e );
 			} );
 		}
 		catch ( ... )
 		{
-			deferred->set_exception( std::current_exception( ) );
+			resolver.reject( std::current_exception( ) );
 		}
 	};
 
-	state_->signal( )->push( std::move( perform ),
-	                         ensure( set_default_forward( queue ) ) );
-
-	return std::move( deferred->get_promise( ) );
+	return observe< unique_this_type >(
+		std::move( observer ),
+		ensure( set_default_forward( queue ) ),
+		next_queue,
+		shared_type( ) );
 }
 
 /**
@@ -173,21 +172,21 @@ typename std::enable_if<
 generic_promise< Shared, Args... >::
 tap( Fn&& fn, Queue&& queue )
 {
-	auto deferred = ::q::make_shared< detail::defer< Args... > >(
-	     is_set_default< Queue >::value
-	     ? ensure( set_default_get( queue ) )
-	     : get_queue( ) );
+	auto next_queue = is_set_default< Queue >::value
+		? ensure( set_default_get( queue ) )
+		: get_queue( );
 	Q_MAKE_MOVABLE( fn );
-	auto state = state_;
 
-	auto perform = [ deferred, Q_MOVABLE_FORWARD( fn ), state ]( ) mutable
+	auto observer = [ Q_MOVABLE_FORWARD( fn ) ](
+		const resolver_type& resolver
+	) mutable
 	{
-		auto value = state->consume( );
+		const tuple_expect_type& value = resolver.value( );
 
 		if ( value.has_exception( ) )
 		{
 			// Redirect exception
-			deferred->set_exception( value.exception( ) );
+			resolver.resolve( );
 			return;
 		}
 
@@ -197,19 +196,21 @@ tap( Fn&& fn, Queue&& queue )
 				Q_MOVABLE_CONSUME( fn ),
 				value.get( )
 			);
-
-			deferred->set_value( value.consume( ) );
 		}
 		catch ( ... )
 		{
-			deferred->set_exception( std::current_exception( ) );
+			resolver.reject( std::current_exception( ) );
+			return;
 		}
-	};
 
-	state_->signal( )->push( std::move( perform ),
-	                         ensure( set_default_forward( queue ) ) );
+		resolver.resolve( );
+	};
 
-	return std::move( deferred->get_promise( ) );
+	return observe< unique_this_type >(
+		std::move( observer ),
+		ensure( set_default_forward( queue ) ),
+		next_queue,
+		shared_type( ) );
 }
 
 /**
@@ -235,52 +236,49 @@ typename std::enable_if<
 generic_promise< Shared, Args... >::
 tap( Fn&& fn, Queue&& queue )
 {
-	auto deferred = ::q::make_shared< detail::defer< Args... > >(
-	      is_set_default< Queue >::value
-	      ? ensure( set_default_get( queue ) )
-	      : get_queue( ) );
+	auto next_queue = is_set_default< Queue >::value
+		? ensure( set_default_get( queue ) )
+		: get_queue( );
 	Q_MAKE_MOVABLE( fn );
-	auto state = state_;
 
-	auto perform = [ deferred, Q_MOVABLE_FORWARD( fn ), state ]( ) mutable
+	auto observer = [ Q_MOVABLE_FORWARD( fn ) ](
+		const resolver_type& resolver
+	) mutable
 	{
-		auto value = state->consume( );
+		const tuple_expect_type& value = resolver.value( );
 
 		if ( value.has_exception( ) )
 		{
 			// Redirect exception
-			deferred->set_exception( value.exception( ) );
+			resolver.resolve( );
 			return;
 		}
 
 		try
 		{
-			auto shared_state = std::make_shared<
-				decltype( value )
-			>( std::move( value ) );
-
 			q::call_with_args(
-				Q_MOVABLE_CONSUME( fn ), shared_state->get( )
+				Q_MOVABLE_CONSUME( fn ), value.get( )
 			)
-			.then( [ deferred, shared_state ]( )
+			.then( [ resolver ]( )
 			{
-				deferred->set_value( shared_state->consume( ) );
+				resolver.resolve( );
 			} )
-			.fail( [ deferred ]( std::exception_ptr e )
+			.fail( [ resolver ]( std::exception_ptr e )
 			{
-				deferred->set_exception( e );
+				resolver.reject( e );
 			} );
 		}
 		catch ( ... )
 		{
-			deferred->set_exception( std::current_exception( ) );
+			resolver.reject( std::current_exception( ) );
 		}
 	};
 
-	state_->signal( )->push( std::move( perform ),
-	                         ensure( set_default_forward( queue ) ) );
-
-	return std::move( deferred->get_promise( ) );
+	return observe< unique_this_type >(
+		std::move( observer ),
+		ensure( set_default_forward( queue ) ),
+		next_queue,
+		shared_type( ) );
 }
 
 } } // namespace detail, namespace q
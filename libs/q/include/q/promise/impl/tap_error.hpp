@@ -42,21 +42,21 @@ typename std::enable_if<
 generic_promise< Shared, Args... >::
 tap_error( Fn&& fn, Queue&& queue )
 {
-	auto deferred = detail::defer< Args... >::construct(
-	    is_set_default< Queue >::value
-	    ? ensure( set_default_get( queue ) )
-	    : get_queue( ) );
+	auto next_queue = is_set_default< Queue >::value
+		? ensure( set_default_get( queue ) )
+		: get_queue( );
 	Q_MAKE_MOVABLE( fn );
-	auto state = state_;
 
-	auto perform = [ deferred, Q_MOVABLE_FORWARD( fn ), state ]( ) mutable
+	auto observer = [ Q_MOVABLE_FORWARD( fn ) ](
+		const resolver_type& resolver
+	) mutable
 	{
-		auto value = state->consume( );
+		const tuple_expect_type& value = resolver.value( );
 
 		if ( !value.has_exception( ) )
 		{
 			// Forward data
-			deferred->set_value( value.consume( ) );
+			resolver.resolve( );
 			return;
 		}
 
@@ -64,20 +64,21 @@ tap_error( Fn&& fn, Queue&& queue )
 		try
 		{
 			Q_MOVABLE_CONSUME( fn )( value.exception( ) );
-
-			deferred->set_exception( value.exception( ) );
 		}
 		catch ( ... )
 		{
-			deferred->set_exception( std::current_exception( ) );
+			resolver.reject( std::current_exception( ) );
 			return;
 		}
-	};
 
-	state_->signal( )->push( std::move( perform ),
-	                         ensure( set_default_forward( queue ) ) );
+		resolver.resolve( );
+	};
 
-	return deferred->template get_suitable_promise< promise_this_type >( );
+	return observe< unique_this_type >(
+		std::move( observer ),
+		ensure( set_default_forward( queue ) ),
+		next_queue,
+		shared_type( ) );
 }
 
 /**
@@ -103,50 +104,48 @@ typename std::enable_if<
 generic_promise< Shared, Args... >::
 tap_error( Fn&& fn, Queue&& queue )
 {
-	auto deferred = detail::defer< Args... >::construct(
-	    is_set_default< Queue >::value
-	    ? ensure( set_default_get( queue ) )
-	    : get_queue( ) );
+	auto next_queue = is_set_default< Queue >::value
+		? ensure( set_default_get( queue ) )
+		: get_queue( );
 	Q_MAKE_MOVABLE( fn );
-	auto state = state_;
 
-	auto perform = [ deferred, Q_MOVABLE_FORWARD( fn ), state ]( ) mutable
+	auto observer = [ Q_MOVABLE_FORWARD( fn ) ](
+		const resolver_type& resolver
+	) mutable
 	{
-		auto value = state->consume( );
+		const tuple_expect_type& value = resolver.value( );
 
 		if ( !value.has_exception( ) )
 		{
 			// Forward data
-			deferred->set_value( value.consume( ) );
+			resolver.resolve( );
 			return;
 		}
 
 		// Redirect exception
 		try
 		{
-			std::exception_ptr error = value.exception( );
-
-			Q_MOVABLE_CONSUME( fn )( error )
-			.then( [ deferred, error ]( )
+			Q_MOVABLE_CONSUME( fn )( value.exception( ) )
+			.then( [ resolver ]( )
 			{
-				deferred->set_exception( error );
+				resolver.resolve( );
 			} )
-			.fail( [ deferred ]( std::exception_ptr e )
+			.fail( [ resolver ]( std::exception_ptr e )
 			{
-				deferred->set_exception( e );
+				resolver.reject( e );
 			} );
 		}
 		catch ( ... )
 		{
-			deferred->set_exception( std::current_exception( ) );
-			return;
+			resolver.reject( std::current_exception( ) );
 		}
 	};
 
-	state_->signal( )->push( std::move( perform ),
-	                         ensure( set_default_forward( queue ) ) );
-
-	return deferred->template get_suitable_promise< promise_this_type >( );
+	return observe< unique_this_type >(
+		std::move( observer ),
+		ensure( set_default_forward( queue ) ),
+		next_queue,
+		shared_type( ) );
 }
 
 /**
@@ -169,24 +168,24 @@ typename std::enable_if<
 generic_promise< Shared, Args... >::
 tap_error( Fn&& fn, Queue&& queue )
 {
-	auto deferred = detail::defer< Args... >::construct(
-	    is_set_default< Queue >::value
-	    ? ensure( set_default_get( queue ) )
-	    : get_queue( ) );
+	auto next_queue = is_set_default< Queue >::value
+		? ensure( set_default_get( queue ) )
+		: get_queue( );
 	Q_MAKE_MOVABLE( fn );
-	auto state = state_;
 
 	typedef typename std::decay< Q_FIRST_ARGUMENT_OF( Fn ) >::type
 		exception_type;
 
-	auto perform = [ deferred, Q_MOVABLE_FORWARD( fn ), state ]( ) mutable
+	auto observer = [ Q_MOVABLE_FORWARD( fn ) ](
+		const resolver_type& resolver
+	) mutable
 	{
-		auto value = state->consume( );
+		const tuple_expect_type& value = resolver.value( );
 
 		if ( !value.has_exception( ) )
 		{
 			// Forward data
-			deferred->set_value( value.consume( ) );
+			resolver.resolve( );
 			return;
 		}
 
@@ -200,25 +199,24 @@ tap_error( Fn&& fn, Queue&& queue )
 			try
 			{
 				Q_MOVABLE_CONSUME( fn )( e );
-
-				deferred->set_exception( e );
 			}
 			catch ( ... )
 			{
-				deferred->set_exception(
-					std::current_exception( ) );
+				resolver.reject( std::current_exception( ) );
+				return;
 			}
 		}
 		catch ( ... )
-		{
-			deferred->set_exception( std::current_exception( ) );
-		}
-	};
+		{ }
 
-	state_->signal( )->push( std::move( perform ),
-	                         ensure( set_default_forward( queue ) ) );
+		resolver.resolve( );
+	};
 
-	return deferred->template get_suitable_promise< promise_this_type >( );
+	return observe< unique_this_type >(
+		std::move( observer ),
+		ensure( set_default_forward( queue ) ),
+		next_queue,
+		shared_type( ) );
 }
 
 /**
@@ -243,64 +241,63 @@ typename std::enable_if<
 generic_promise< Shared, Args... >::
 tap_error( Fn&& fn, Queue&& queue )
 {
-	auto deferred = detail::defer< Args... >::construct(
-	    is_set_default< Queue >::value
-	    ? ensure( set_default_get( queue ) )
-	    : get_queue( ) );
+	auto next_queue = is_set_default< Queue >::value
+		? ensure( set_default_get( queue ) )
+		: get_queue( );
 	Q_MAKE_MOVABLE( fn );
-	auto state = state_;
 
 	typedef typename std::decay< Q_FIRST_ARGUMENT_OF( Fn ) >::type
 		exception_type;
 
-	auto perform = [ deferred, Q_MOVABLE_FORWARD( fn ), state ]( ) mutable
+	auto observer = [ Q_MOVABLE_FORWARD( fn ) ](
+		const resolver_type& resolver
+	) mutable
 	{
-		auto value = state->consume( );
+		const tuple_expect_type& value = resolver.value( );
 
 		if ( !value.has_exception( ) )
 		{
 			// Forward data
-			deferred->set_value( value.consume( ) );
+			resolver.resolve( );
 			return;
 		}
 
-		std::exception_ptr error = value.exception( );
-
 		// Handle exception, if it's our type
 		try
 		{
-			std::rethrow_exception( error );
+			std::rethrow_exception( value.exception( ) );
 		}
 		catch ( exception_type& e )
 		{
 			try
 			{
 				Q_MOVABLE_CONSUME( fn )( e )
-				.then( [ deferred, error ]( )
+				.then( [ resolver ]( )
 				{
-					deferred->set_exception( error );
+					resolver.resolve( );
 				} )
-				.fail( [ deferred ]( std::exception_ptr e )
+				.fail( [ resolver ]( std::exception_ptr e )
 				{
-					deferred->set_exception( e );
+					resolver.reject( e );
 				} );
 			}
 			catch ( ... )
 			{
-				deferred->set_exception(
-					std::current_exception( ) );
+				resolver.reject( std::current_exception( ) );
 			}
+			return;
 		}
 		catch ( ... )
-		{
-			deferred->set_exception( std::current_exception( ) );
-		}
-	};
+		{ }
 
-	state_->signal( )->push( std::move( perform ),
-	                         ensure( set_default_forward( queue ) ) );
+		resolver.resolve( );
+	};
 
-	return deferred->template get_suitable_promise< promise_this_type >( );
+	return observe< unique_this_type >(
+		std::move( observer ),
+		ensure( set_default_forward( queue ) ),
+		next_queue,
+		shared_type( ) );
 }
 
 } } // namespace detail, namespace q
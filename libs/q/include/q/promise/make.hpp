@@ -126,10 +126,11 @@ make_promise( const queue_ptr& queue, Fn&& fn )
 
 	Q_MAKE_MOVABLE( fn );
 
-	queue->push( [ deferred, Q_MOVABLE_FORWARD( fn ) ]( ) mutable
+	queue->push( ::q::detail::with_current_context(
+		[ deferred, Q_MOVABLE_FORWARD( fn ) ]( ) mutable
 	{
 		deferred->set_by_fun( Q_MOVABLE_CONSUME( fn ) );
-	} );
+	} ) );
 
 	return deferred->get_promise( );
 }
@@ -184,10 +185,11 @@ make_promise( const ::q::queue_ptr& queue, Fn&& fn )
 
 	Q_MAKE_MOVABLE( fn );
 
-	queue->push( [ helper, Q_MOVABLE_FORWARD( fn ) ]( ) mutable
+	queue->push( ::q::detail::with_current_context(
+		[ helper, Q_MOVABLE_FORWARD( fn ) ]( ) mutable
 	{
 		helper->run( Q_MOVABLE_CONSUME( fn ) );
-	} );
+	} ) );
 
 	return helper->get_promise( );
 }
@@ -234,7 +236,8 @@ make_promise_of( const ::q::queue_ptr& queue, Fn&& fn )
 
 	auto deferred = q::detail::defer< tuple_type >::construct( queue );
 
-	queue->push( [ deferred, Q_MOVABLE_FORWARD( fn ) ]( ) mutable
+	queue->push( ::q::detail::with_current_context(
+		[ deferred, Q_MOVABLE_FORWARD( fn ) ]( ) mutable
 	{
 		auto resolve = [ deferred ]( Args&&... args )
 		{
@@ -255,7 +258,7 @@ make_promise_of( const ::q::queue_ptr& queue, Fn&& fn )
 			deferred->set_exception( std::current_exception( ) );
 		}
 
-	} );
+	} ) );
 
 	return deferred->get_promise( );
 }
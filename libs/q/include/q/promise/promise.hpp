@@ -70,6 +70,7 @@ public:
 	typedef shared_promise< Args... >              shared_this_type;
 	typedef make_promise_type_t< Shared, Args... > promise_this_type;
 	typedef promise_state< tuple_type, Shared >    state_type;
+	typedef observer_resolver< Shared, Args... >   resolver_type;
 	typedef promise_state< tuple_type, false >     unique_state_type;
 	typedef unique_this_type                       promise_type;
 	typedef shared_this_type                       shared_promise_type;
@@ -251,6 +252,21 @@ public:
 	>::type
 	then( Fn&& fn, Queue&& queue = nullptr );
 
+	/**
+	 * Like then( fn ), but hints that the continuation should run on the
+	 * thread which resolves this promise, see affinity::resolver. The
+	 * continuation is scheduled on the queue of this promise.
+	 */
+	template< typename Fn >
+	auto then( Fn&& fn, affinity::resolver_t )
+	-> decltype(
+		std::declval< this_type& >( ).then( std::forward< Fn >( fn ) ) )
+	{
+		detail::resolver_affinity_scope scope;
+
+		return then( std::forward< Fn >( fn ) );
+	}
+
 	template< typename Logger, typename Queue = queue_ptr >
 	typename std::enable_if<
 		is_same_type< Logger, log_chain_generator >::value
@@ -683,6 +699,33 @@ private:
 	friend class ::q::promise< Args... >;
 	friend class ::q::shared_promise< Args... >;
 
+	/**
+	 * Chains an observer (i.e. tap(), tap_error() or finally()) onto this
+	 * promise. The observer is called with a resolver, through which it
+	 * can inspect the value (or exception) by const reference, and which it
+	 * must use to either forward the value untouched or replace it with an
+	 * exception.
+	 *
+	 * For unique promises, the returned promise shares the state of this
+	 * promise, i.e. no new promise is allocated and the value isn't moved
+	 * between the observers.
+	 */
+	template< typename Promise, typename Observer >
+	Promise observe(
+		Observer&& observer,
+		const queue_ptr& queue,
+		const queue_ptr& next_queue,
+		std::false_type
+	);
+
+	template< typename Promise, typename Observer >
+	Promise observe(
+		Observer&& observer,
+		const queue_ptr& queue,
+		const queue_ptr& next_queue,
+		std::true_type
+	);
+
 	template< typename Queue >
 	typename std::enable_if<
 		std::is_same<
@@ -737,6 +780,16 @@ public:
 	>::type
 	share( )
 	{
+		if ( base_type::state_->observed( ) )
+			// The value is still to be inspected by an observer, so
+			// it cannot be moved out of this state yet.
+			return this->then(
+				[ ]( typename base_type::tuple_type&& value )
+				{
+					return std::move( value );
+				}
+			).share( );
+
 		return shared_promise< T... >(
 			base_type::state_->acquire( ), this->get_queue( ) );
 	}
@@ -53,8 +53,46 @@ struct promisifier< Ret, ::q::arguments< Args... > >
 		)
 		.share( );
 	}
+
+	template< typename Fn >
+	static q::function< promise_type( Args... ) >
+	promisify_on( queue_ptr&& queue, Fn&& fn )
+	{
+		typedef typename std::decay< Fn >::type fn_type;
+
+		Q_MAKE_MOVABLE( fn );
+
+		return q::unique_function< promise_type( Args... ) >(
+			[ queue, Q_MOVABLE_FORWARD( fn ) ]( Args... args )
+			mutable
+			-> promise_type
+			{
+				return ::q::async(
+					queue,
+					fn_type( Q_MOVABLE_GET( fn ) ),
+					std::forward< Args >( args )...
+				);
+			}
+		)
+		.share( );
+	}
 };
 
+template< typename Ret, typename Args >
+struct async_promisifier
+: promisifier< Ret, Args >
+{ };
+
+template< typename... T, typename Args >
+struct async_promisifier< ::q::promise< T... >, Args >
+: promisifier< std::tuple< T... >, Args >
+{ };
+
+template< typename... T, typename Args >
+struct async_promisifier< ::q::shared_promise< T... >, Args >
+: promisifier< std::tuple< T... >, Args >
+{ };
+
 } // namespace detail
 
 /**
@@ -82,6 +120,26 @@ promisify( queue_ptr, Fn&& fn )
 	return fn;
 }
 
+/**
+ * Converts a function into a function returning a promise, like promisify(),
+ * except that each call is scheduled on @c queue (using q::async()), rather
+ * than being performed synchronously by the caller. This makes it suitable
+ * for e.g. CPU heavy functions to be run on a threadpool.
+ *
+ * Functions already returning promises are also scheduled on @c queue.
+ */
+template< typename Fn >
+decltype(
+	detail::async_promisifier< result_of_t< Fn >, arguments_of_t< Fn > >
+	::promisify_on( nullptr, std::declval< Fn >( ) )
+)
+promisify_on( queue_ptr queue, Fn&& fn )
+{
+	return detail::async_promisifier<
+		result_of_t< Fn >, arguments_of_t< Fn >
+	>::promisify_on( std::move( queue ), std::forward< Fn >( fn ) );
+}
+
 } // namespace q
 
 #endif // LIBQ_PROMISE_PROMISIFY_HPP
@@ -46,6 +46,24 @@ private:
 
 typedef std::shared_ptr< promise_signal > promise_signal_ptr;
 
+/**
+ * While in scope, tasks pushed to promise signals (by the current thread) are
+ * marked to be scheduled with affinity::resolver once the promise is resolved.
+ */
+class resolver_affinity_scope
+{
+public:
+	resolver_affinity_scope( ) noexcept;
+	~resolver_affinity_scope( );
+
+	resolver_affinity_scope( const resolver_affinity_scope& ) = delete;
+	resolver_affinity_scope& operator=(
+		const resolver_affinity_scope& ) = delete;
+
+private:
+	bool previous_;
+};
+
 } } // namespace detail, namespace queue
 
 #endif // LIBQ_PROMISE_SIGNAL_HPP
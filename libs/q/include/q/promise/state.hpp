@@ -78,6 +78,14 @@ public:
 		return data_->future.get( );
 	}
 
+	/**
+	 * Inspects the (resolved) value without copying it.
+	 */
+	const typename state_type::value_type& peek( ) const
+	{
+		return data_->future.get( );
+	}
+
 	promise_signal_ptr signal( )
 	{
 		return data_->signal;
@@ -97,17 +105,35 @@ private:
 	std::shared_ptr< state_type > data_;
 };
 
+/**
+ * The unique state can be observed (by e.g. tap() or finally()) without the
+ * value being consumed. When observed, the value is moved out of the future
+ * once, into the state itself, where it can be inspected any number of times
+ * by subsequent observers, and eventually be consumed.
+ */
 template< typename T >
 class unique_state
 {
 	typedef promise_state_data< T, false > state_type;
+	typedef typename state_type::value_type value_type;
 
 public:
 	unique_state( ) = delete;
 	unique_state( const unique_state< T >& ) = delete;
 	unique_state( unique_state< T >&& s )// = default;
 	: data_( std::move( s.data_ ) )
-	{ }
+	, observed_( s.observed_ )
+	, materialized_( false )
+	{
+		if ( s.materialized_ )
+			materialize( std::move( s.slot( ) ) );
+	}
+
+	~unique_state( )
+	{
+		if ( materialized_ )
+			slot( ).~value_type( );
+	}
 
 	typename state_type::value_type& ref( )
 	{
@@ -116,9 +142,53 @@ public:
 
 	typename state_type::value_type consume( )
 	{
+		if ( materialized_ )
+			return std::move( slot( ) );
 		return std::move( data_.future.get( ) );
 	}
 
+	/**
+	 * Inspects the (resolved) value without consuming it.
+	 */
+	const value_type& peek( )
+	{
+		if ( !materialized_ )
+			materialize( std::move( data_.future.get( ) ) );
+		return slot( );
+	}
+
+	/**
+	 * Replaces the (resolved) value with an exception.
+	 */
+	void reject( const std::exception_ptr& e )
+	{
+		peek( );
+		slot( ) = value_type( e );
+	}
+
+	/**
+	 * Prepares this state for being observed, by giving it a new signal.
+	 * The old signal is returned, and is the one on which the observer is
+	 * to be registered. The observer must, when done, trigger the new
+	 * signal.
+	 */
+	promise_signal_ptr observe( )
+	{
+		auto signal = make_shared< promise_signal >( );
+		std::swap( signal, data_.signal );
+		observed_ = true;
+		return signal;
+	}
+
+	/**
+	 * Whether this state has been observed, in which case its data cannot
+	 * be acquired by another state.
+	 */
+	bool observed( ) const
+	{
+		return observed_;
+	}
+
 	promise_signal_ptr signal( )
 	{
 		return data_.signal;
@@ -132,10 +202,28 @@ public:
 protected:
 	unique_state( state_type&& data )
 	: data_( std::move( data ) )
+	, observed_( false )
+	, materialized_( false )
 	{ }
 
 private:
+	void materialize( value_type&& value )
+	{
+		::new ( &slot_ ) value_type( std::move( value ) );
+		materialized_ = true;
+	}
+
+	value_type& slot( )
+	{
+		return *reinterpret_cast< value_type* >( &slot_ );
+	}
+
 	state_type data_;
+	bool observed_;
+	bool materialized_;
+	typename std::aligned_storage<
+		sizeof( value_type ), alignof( value_type )
+	>::type slot_;
 };
 
 template< typename T, bool Shared >
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2016 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_PROMISE_YIELD_HPP
+#define LIBQ_PROMISE_YIELD_HPP
+
+#include <q/this_task.hpp>
+
+namespace q {
+
+/**
+ * Returns a promise whose continuations will be scheduled at the back of
+ * @c queue, i.e. after the tasks which are already waiting on it. This lets a
+ * long-running task continue its work after other tasks have run:
+ *
+ *   if ( q::this_task::should_yield( ) )
+ *       return q::yield( queue ).then( [ ]( ) { ...the rest... } );
+ */
+inline promise< > yield( const queue_ptr& queue )
+{
+	return with( queue );
+}
+
+} // namespace q
+
+#endif // LIBQ_PROMISE_YIELD_HPP
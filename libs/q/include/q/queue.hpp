@@ -23,6 +23,7 @@
 #include <q/timer.hpp>
 
 #include <memory>
+#include <cstdint>
 
 namespace q {
 
@@ -47,6 +48,15 @@ struct timer_task
 	, is_timed_( true )
 	{ }
 
+	timer_task( task&& _task,
+	            timer::point_type&& _wait_until,
+	            timer::duration_type _slack )
+	: task_( std::move( _task ) )
+	, wait_until_( std::move( _wait_until ) )
+	, slack_( _slack )
+	, is_timed_( true )
+	{ }
+
 	bool operator!( ) const
 	{
 		return !this->task_;
@@ -70,10 +80,49 @@ struct timer_task
 	task task_;
 	timer::point_type wait_until_;
 
+	// How long after wait_until_ the task may run, allowing the dispatcher
+	// to coalesce timers into fewer wake-ups.
+	timer::duration_type slack_ = timer::duration_type::zero( );
+
 private:
 	bool is_timed_;
 };
 
+/**
+ * The priority class of a task within a single queue. Tasks of a higher class
+ * are popped before tasks of lower classes, regardless of the order they were
+ * pushed in. Tasks of the same class are popped in FIFO order.
+ *
+ * This is independent of the queue priority, which the scheduler uses to
+ * prioritize between queues.
+ */
+enum class priority_class : std::uint8_t
+{
+	background = 0,
+	normal     = 1,
+	high       = 2,
+	urgent     = 3
+};
+
+class basic_event_dispatcher;
+
+namespace affinity {
+
+/**
+ * Hints that a task (e.g. a continuation of a promise) should run on the
+ * thread which pushes it, i.e. the thread which resolved the promise, while
+ * its data is still hot in that thread's cache.
+ *
+ * This is only a hint. It is followed if the pushing thread belongs to the
+ * event dispatcher consuming the queue, and if that dispatcher supports it
+ * (like the threadpool). Otherwise the task is pushed like any other task.
+ */
+struct resolver_t { };
+
+constexpr resolver_t resolver{ };
+
+} // namespace affinity
+
 class queue
 : public std::enable_shared_from_this< queue >
 {
@@ -85,16 +134,55 @@ public:
 
 	~queue( );
 
+	static constexpr std::size_t num_priority_classes = 4;
+
+	/**
+	 * Pushes a task with the normal priority class
+	 */
 	void push( task&& task );
+	void push( task&& task, priority_class priority );
+
+	/**
+	 * Pushes a task to the local slot of the current thread, if it is a
+	 * thread of the event dispatcher consuming this queue. The task will
+	 * then run next on this thread, or be stolen by other threads of the
+	 * dispatcher. A task previously in the slot is pushed to this queue.
+	 */
+	void push( task&& task, affinity::resolver_t );
+	/**
+	 * Pushes a task to run at @c wait_until, or at most the timer slack of
+	 * this queue later.
+	 */
 	void push( task&& task, timer::point_type wait_until );
 
+	/**
+	 * Pushes a task to run at @c wait_until, or at most @c slack later.
+	 */
+	void push( task&& task,
+	           timer::point_type wait_until,
+	           timer::duration_type slack );
+
+	/**
+	 * Sets the default timer slack of the timed tasks pushed to this queue,
+	 * e.g. 5ms means that they may run up to 5ms after their time. Event
+	 * dispatchers use this to group expiring timers into shared wake-ups.
+	 * The default is no slack.
+	 */
+	void set_timer_slack( timer::duration_type slack );
+	timer::duration_type timer_slack( ) const;
+
 	priority_t priority( ) const;
 
 	/**
 	 * Sets a function callback as consumer of the queue. The queue will
 	 * call this function each time a task is added to the queue.
+	 *
+	 * The event dispatcher, if given, is used to find the local slot of
+	 * the current thread, when pushing tasks with affinity::resolver.
 	 */
-	void set_consumer( notify_type fn, std::size_t parallelism );
+	void set_consumer( notify_type fn,
+	                   std::size_t parallelism,
+	                   const basic_event_dispatcher* dispatcher = nullptr );
 
 	bool empty( );
 
@@ -0,0 +1,541 @@
+/*
+ * Copyright 2016 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_RESOURCE_POOL_HPP
+#define LIBQ_RESOURCE_POOL_HPP
+
+#include <q/promise.hpp>
+#include <q/mutex.hpp>
+#include <q/timer.hpp>
+#include <q/function.hpp>
+
+#include <deque>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+namespace q {
+
+template< typename T >
+class resource_pool;
+
+template< typename T >
+class pooled;
+
+/**
+ * Accumulated counters of a resource_pool.
+ */
+struct resource_pool_statistics
+{
+	resource_pool_statistics( )
+	: acquired( 0 )
+	, waited( 0 )
+	, created( 0 )
+	, evicted( 0 )
+	, wait_time( timer::duration_type::zero( ) )
+	, max_wait_time( timer::duration_type::zero( ) )
+	{ }
+
+	/** The number of successful acquisitions */
+	std::size_t acquired;
+
+	/** The number of those acquisitions which had to wait */
+	std::size_t waited;
+
+	/** The number of objects created by the factory */
+	std::size_t created;
+
+	/** The number of idle objects evicted */
+	std::size_t evicted;
+
+	/** The total time spent waiting, summed over all acquisitions */
+	timer::duration_type wait_time;
+
+	/** The longest time an acquisition has waited */
+	timer::duration_type max_wait_time;
+};
+
+namespace detail {
+
+template< typename T >
+class resource_pool_state
+: public std::enable_shared_from_this< resource_pool_state< T > >
+{
+public:
+	typedef q::unique_function< std::unique_ptr< T >( ) > factory_type;
+	typedef detail::defer< pooled< T > >                   defer_type;
+
+	resource_pool_state(
+		const queue_ptr& queue, factory_type&& factory, std::size_t max
+	)
+	: queue_( queue )
+	, factory_( std::move( factory ) )
+	, max_( std::max< std::size_t >( max, 1 ) )
+	, idle_timeout_( timer::duration_type::zero( ) )
+	, mutex_( Q_HERE, "resource_pool" )
+	, size_( 0 )
+	, eviction_scheduled_( false )
+	{ }
+
+	promise< pooled< T > > acquire( )
+	{
+		Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+		if ( !idle_.empty( ) )
+		{
+			// Reuse the most recently returned object, which is the
+			// most likely to still be warm in caches
+			auto object = std::move( idle_.back( ).object );
+			idle_.pop_back( );
+
+			++statistics_.acquired;
+
+			return with(
+				queue_,
+				pooled< T >(
+					this->shared_from_this( ),
+					std::move( object ) ) );
+		}
+
+		waiters_.push_back( waiter{
+			defer_type::construct( queue_ ),
+			timer::clock::now( )
+		} );
+
+		auto promise = waiters_.back( ).deferred->get_promise( );
+
+		if ( size_ < max_ )
+		{
+			++size_;
+			create( );
+		}
+
+		return promise;
+	}
+
+	void release( std::unique_ptr< T >&& object )
+	{
+		std::shared_ptr< defer_type > deferred;
+
+		{
+			Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+			if ( waiters_.empty( ) )
+			{
+				idle_.push_back( idle_entry{
+					std::move( object ), timer::clock::now( )
+				} );
+
+				schedule_eviction( );
+				return;
+			}
+
+			deferred = pop_waiter( );
+		}
+
+		deferred->set_value( std::make_tuple( pooled< T >(
+			this->shared_from_this( ), std::move( object ) ) ) );
+	}
+
+	void discard( std::unique_ptr< T >&& object )
+	{
+		object.reset( );
+
+		Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+		--size_;
+
+		// Replace the object for the first waiter (if any)
+		if ( !waiters_.empty( ) )
+		{
+			++size_;
+			create( );
+		}
+	}
+
+	void set_idle_timeout( timer::duration_type timeout )
+	{
+		Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+		idle_timeout_ = timeout;
+		schedule_eviction( );
+	}
+
+	std::size_t evict_idle( )
+	{
+		std::deque< idle_entry > evicted;
+
+		{
+			Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+			evicted.swap( idle_ );
+			size_ -= evicted.size( );
+			statistics_.evicted += evicted.size( );
+		}
+
+		return evicted.size( );
+	}
+
+	std::size_t size( ) const
+	{
+		Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+		return size_;
+	}
+
+	std::size_t idle( ) const
+	{
+		Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+		return idle_.size( );
+	}
+
+	std::size_t waiting( ) const
+	{
+		Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+		return waiters_.size( );
+	}
+
+	resource_pool_statistics statistics( ) const
+	{
+		Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+		return statistics_;
+	}
+
+private:
+	struct waiter
+	{
+		std::shared_ptr< defer_type > deferred;
+		timer::point_type since;
+	};
+
+	struct idle_entry
+	{
+		std::unique_ptr< T > object;
+		timer::point_type since;
+	};
+
+	// Must be called with the mutex locked
+	std::shared_ptr< defer_type > pop_waiter( )
+	{
+		auto waiter = std::move( waiters_.front( ) );
+		waiters_.pop_front( );
+
+		auto waited = timer::clock::now( ) - waiter.since;
+
+		++statistics_.acquired;
+		++statistics_.waited;
+		statistics_.wait_time += waited;
+		statistics_.max_wait_time =
+			std::max( statistics_.max_wait_time, waited );
+
+		return std::move( waiter.deferred );
+	}
+
+	/**
+	 * Creates a new object on the queue of the pool, and hands it to the
+	 * first waiter. The size must have been incremented for it already.
+	 */
+	void create( )
+	{
+		auto self = this->shared_from_this( );
+
+		queue_->push( [ self ]( )
+		{
+			std::unique_ptr< T > object;
+			std::exception_ptr error;
+
+			try
+			{
+				object = self->factory_( );
+			}
+			catch ( ... )
+			{
+				error = std::current_exception( );
+			}
+
+			if ( object )
+			{
+				{
+					Q_AUTO_UNIQUE_LOCK( self->mutex_ );
+
+					++self->statistics_.created;
+				}
+
+				self->release( std::move( object ) );
+				return;
+			}
+
+			if ( !error )
+				error = std::make_exception_ptr(
+					std::runtime_error(
+						"resource_pool factory returned "
+						"no object" ) );
+
+			std::shared_ptr< defer_type > deferred;
+
+			{
+				Q_AUTO_UNIQUE_LOCK( self->mutex_ );
+
+				--self->size_;
+
+				if ( self->waiters_.empty( ) )
+					return;
+
+				auto waiter = std::move(
+					self->waiters_.front( ) );
+				self->waiters_.pop_front( );
+				deferred = std::move( waiter.deferred );
+			}
+
+			deferred->set_exception( error );
+		} );
+	}
+
+	// Must be called with the mutex locked
+	void schedule_eviction( )
+	{
+		if (
+			eviction_scheduled_ ||
+			idle_.empty( ) ||
+			idle_timeout_ <= timer::duration_type::zero( )
+		)
+			return;
+
+		eviction_scheduled_ = true;
+
+		std::weak_ptr< resource_pool_state > weak_self =
+			this->shared_from_this( );
+
+		queue_->push( [ weak_self ]( )
+		{
+			auto self = weak_self.lock( );
+			if ( self )
+				self->evict_expired( );
+		}, idle_.front( ).since + idle_timeout_ );
+	}
+
+	void evict_expired( )
+	{
+		std::deque< idle_entry > evicted;
+
+		{
+			Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+			eviction_scheduled_ = false;
+
+			auto expired = timer::clock::now( ) - idle_timeout_;
+
+			// The idle objects are ordered by the time they were
+			// returned, oldest first
+			while ( !idle_.empty( ) && idle_.front( ).since <= expired )
+			{
+				evicted.push_back( std::move( idle_.front( ) ) );
+				idle_.pop_front( );
+			}
+
+			size_ -= evicted.size( );
+			statistics_.evicted += evicted.size( );
+
+			schedule_eviction( );
+		}
+	}
+
+	queue_ptr queue_;
+	factory_type factory_;
+	const std::size_t max_;
+	timer::duration_type idle_timeout_;
+	mutable mutex mutex_;
+	std::size_t size_;
+	bool eviction_scheduled_;
+	std::deque< idle_entry > idle_;
+	std::deque< waiter > waiters_;
+	resource_pool_statistics statistics_;
+};
+
+} // namespace detail
+
+/**
+ * A pooled< T > is a handle to an object acquired from a resource_pool. When
+ * the handle is destructed, the object is returned to the pool, or handed
+ * directly to the next waiting acquirer.
+ */
+template< typename T >
+class pooled
+{
+public:
+	pooled( ) = default;
+	pooled( pooled&& ) = default;
+	pooled( const pooled& ) = delete;
+
+	pooled& operator=( pooled&& other )
+	{
+		reset( );
+		pool_ = std::move( other.pool_ );
+		object_ = std::move( other.object_ );
+		return *this;
+	}
+
+	pooled& operator=( const pooled& ) = delete;
+
+	~pooled( )
+	{
+		reset( );
+	}
+
+	T& operator*( ) const
+	{
+		return *object_;
+	}
+
+	T* operator->( ) const
+	{
+		return object_.get( );
+	}
+
+	T* get( ) const
+	{
+		return object_.get( );
+	}
+
+	explicit operator bool( ) const
+	{
+		return !!object_;
+	}
+
+	/**
+	 * Returns the object to the pool before the handle is destructed.
+	 */
+	void reset( )
+	{
+		if ( pool_ && object_ )
+			pool_->release( std::move( object_ ) );
+		pool_.reset( );
+	}
+
+	/**
+	 * Destroys the object rather than returning it to the pool, e.g. if it
+	 * has become broken. This frees room in the pool for a new object.
+	 */
+	void discard( )
+	{
+		if ( pool_ && object_ )
+			pool_->discard( std::move( object_ ) );
+		pool_.reset( );
+	}
+
+private:
+	friend class detail::resource_pool_state< T >;
+
+	pooled(
+		std::shared_ptr< detail::resource_pool_state< T > > pool,
+		std::unique_ptr< T >&& object
+	)
+	: pool_( std::move( pool ) )
+	, object_( std::move( object ) )
+	{ }
+
+	std::shared_ptr< detail::resource_pool_state< T > > pool_;
+	std::unique_ptr< T > object_;
+};
+
+/**
+ * A resource_pool< T > keeps a bounded set of expensive objects, e.g. file
+ * handles or large scratch buffers. Objects are created lazily by the factory
+ * (on the queue of the pool), up to the max size. When all are in use,
+ * acquirers wait in FIFO order, and are handed objects directly as they are
+ * returned.
+ *
+ * The factory returns a std::unique_ptr< T >. If it throws (or returns null),
+ * the waiting acquirer gets the error. If the queue is backed by a threadpool,
+ * the factory may be called concurrently.
+ *
+ * Copies of a resource_pool refer to the same pool.
+ */
+template< typename T >
+class resource_pool
+{
+public:
+	typedef typename detail::resource_pool_state< T >::factory_type
+		factory_type;
+
+	resource_pool(
+		const queue_ptr& queue, factory_type factory, std::size_t max
+	)
+	: state_( std::make_shared< detail::resource_pool_state< T > >(
+		queue, std::move( factory ), max ) )
+	{ }
+
+	/**
+	 * Acquires an object from the pool. The promise is resolved when an
+	 * idle object is available, a new one has been created, or one is
+	 * returned by another user.
+	 */
+	Q_NODISCARD
+	promise< pooled< T > > acquire( )
+	{
+		return state_->acquire( );
+	}
+
+	/**
+	 * Evicts objects which have been idle longer than @c timeout. A zero
+	 * timeout (the default) disables eviction.
+	 */
+	void set_idle_timeout( timer::duration_type timeout )
+	{
+		state_->set_idle_timeout( timeout );
+	}
+
+	/**
+	 * Evicts all idle objects now, and returns how many were evicted.
+	 */
+	std::size_t evict_idle( )
+	{
+		return state_->evict_idle( );
+	}
+
+	/** The number of objects, both idle and in use */
+	std::size_t size( ) const
+	{
+		return state_->size( );
+	}
+
+	/** The number of idle objects */
+	std::size_t idle( ) const
+	{
+		return state_->idle( );
+	}
+
+	/** The number of acquirers waiting for an object */
+	std::size_t waiting( ) const
+	{
+		return state_->waiting( );
+	}
+
+	resource_pool_statistics statistics( ) const
+	{
+		return state_->statistics( );
+	}
+
+private:
+	std::shared_ptr< detail::resource_pool_state< T > > state_;
+};
+
+} // namespace q
+
+#endif // LIBQ_RESOURCE_POOL_HPP
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2016 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_THIS_TASK_HPP
+#define LIBQ_THIS_TASK_HPP
+
+#include <q/types.hpp>
+#include <q/timer.hpp>
+
+#include <atomic>
+#include <cstddef>
+
+namespace q {
+
+class basic_event_dispatcher;
+
+namespace detail {
+
+/**
+ * A slot local to a thread of an event dispatcher, holding a task which will
+ * run next on that thread (unless stolen by another thread).
+ */
+class local_slot
+{
+public:
+	/**
+	 * Puts @c task in the slot. The task previously in the slot (if any)
+	 * is moved to @c task, and must be scheduled by the caller.
+	 */
+	virtual void swap_in( task& task ) noexcept = 0;
+
+protected:
+	~local_slot( )
+	{ }
+};
+
+/**
+ * Called by event dispatcher threads to register (or with nullptr, unregister)
+ * their local slot, and their index among the threads of the dispatcher.
+ */
+void set_local_slot(
+	const basic_event_dispatcher* dispatcher,
+	local_slot* slot,
+	std::size_t index = 0 ) noexcept;
+
+/**
+ * Returns the index of the current thread among the threads of @c dispatcher,
+ * or -1 if the current thread doesn't belong to it.
+ */
+std::ptrdiff_t current_worker_index(
+	const basic_event_dispatcher* dispatcher ) noexcept;
+
+/**
+ * Registers a function to be called when the current event dispatcher thread
+ * exits, i.e. when its dispatcher is terminated. Must only be called from
+ * threads with a registered local slot.
+ */
+void at_worker_exit( task&& fn );
+
+/**
+ * Called by event dispatcher threads before they exit, to run the functions
+ * registered by at_worker_exit( ), in reverse order.
+ */
+void worker_exit( ) noexcept;
+
+/**
+ * Swaps @c task into the local slot of the current thread, if the thread
+ * belongs to @c dispatcher. Otherwise @c task is left untouched.
+ */
+void push_to_local_slot(
+	const basic_event_dispatcher* dispatcher, task& task ) noexcept;
+
+/**
+ * Called by event dispatchers before running each task, with the number of
+ * tasks waiting to be run by the same dispatcher, or nullptr if unknown.
+ */
+void begin_task( const std::atomic< std::ptrdiff_t >* backlog ) noexcept;
+
+} // namespace detail
+
+namespace this_task {
+
+/**
+ * Returns true if the currently running task should yield, i.e. let other
+ * tasks run before continuing, which is the case when it has run for longer
+ * than @c time_slice while other tasks are waiting to be run by the same
+ * event dispatcher. If the dispatcher doesn't report its backlog, only the
+ * time slice is considered.
+ *
+ * The time slice is counted from the first call to should_yield() within the
+ * task, so long-running tasks should call it regularly, e.g. once per item.
+ *
+ * Typically used together with q::yield().
+ */
+bool should_yield(
+	timer::duration_type time_slice = std::chrono::milliseconds( 1 ) );
+
+} // namespace this_task
+
+} // namespace q
+
+#endif // LIBQ_THIS_TASK_HPP
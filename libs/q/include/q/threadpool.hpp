@@ -24,6 +24,7 @@ namespace q {
 
 class threadpool
 : public event_dispatcher< q::arguments< termination > >
+, public tunable_event_dispatcher
 , public std::enable_shared_from_this< threadpool >
 {
 public:
@@ -38,6 +39,11 @@ public:
 
 	std::size_t parallelism( ) const override;
 
+	dispatcher_tunables tunables( ) const override;
+	void set_tunables( const dispatcher_tunables& ) override;
+	void collect_statistics( bool enable ) override;
+	dispatcher_statistics statistics( ) const override;
+
 	static std::shared_ptr< threadpool >
 	construct( const std::string& name,
 	           const queue_ptr& queue,
@@ -20,6 +20,7 @@
 #include <q/timer.hpp>
 
 #include <map>
+#include <set>
 
 namespace q {
 
@@ -66,6 +67,10 @@ struct time_set_less_than
  * This is useful to order data by time, and quickly be able to find the
  * closest data by time, as well as to find how long until the next time
  * (closest to now).
+ *
+ * Each element can have a slack, i.e. a duration after its time within which
+ * it is acceptable to handle it. next_time() returns the time until the
+ * earliest time + slack, so that a single wake-up can handle multiple elements.
  */
 template<
 	typename T,
@@ -82,9 +87,14 @@ public:
 	static_assert(
 		!std::is_reference< T >::value, "References not allowed" );
 
-	void push( timer::point_type time, T t )
+	void push( timer::point_type time,
+	           T t,
+	           timer::duration_type slack = timer::duration_type::zero( ) )
 	{
-		map_.emplace( std::move( time ), std::move( t ) );
+		auto latest = latest_.insert( time + slack );
+
+		map_.emplace(
+			std::move( time ), entry_type( std::move( t ), latest ) );
 	}
 
 	bool exists_before_or_at( timer::point_type time )
@@ -110,8 +120,9 @@ public:
 		if ( iter == map_.end( ) )
 			return IfEmpty::empty( );
 
-		T value = std::move( iter->second );
+		T value = std::move( iter->second.first );
 
+		latest_.erase( iter->second.second );
 		map_.erase( iter );
 
 		if ( is_default::value )
@@ -120,14 +131,18 @@ public:
 		return IfEmpty::value( std::move( value ) );
 	}
 
+	/**
+	 * The duration until the first element must be handled, taking slack
+	 * into account.
+	 */
 	timer::duration_type next_time( ) const
 	{
-		auto iter = map_.begin( );
+		auto iter = latest_.begin( );
 
-		if ( iter == map_.end( ) )
+		if ( iter == latest_.end( ) )
 			return timer::duration_type::max( );
 
-		return iter->first - timer::point_type::clock::now( );
+		return *iter - timer::point_type::clock::now( );
 	}
 
 	bool empty( ) const
@@ -136,7 +151,11 @@ public:
 	}
 
 private:
-	std::multimap< timer::point_type, T > map_;
+	typedef std::multiset< timer::point_type > latest_set_type;
+	typedef std::pair< T, typename latest_set_type::iterator > entry_type;
+
+	std::multimap< timer::point_type, entry_type > map_;
+	latest_set_type latest_;
 };
 
 } // namespace q
@@ -18,6 +18,7 @@
 #define LIBQ_TIMER_HPP
 
 #include <q/promise/async_task.hpp>
+#include <q/clock.hpp>
 
 #include <chrono>
 
@@ -26,16 +27,17 @@ namespace q {
 class timer
 {
 public:
-	typedef std::chrono::high_resolution_clock::time_point point_type;
-	typedef std::chrono::high_resolution_clock::duration duration_type;
+	typedef steady_clock clock;
+	typedef clock::time_point point_type;
+	typedef clock::duration duration_type;
 
 	timer( )
-	: before_( std::chrono::high_resolution_clock::now( ) )
+	: before_( clock::now( ) )
 	{ }
 
 	duration_type diff( ) const
 	{
-		point_type now = std::chrono::high_resolution_clock::now( );
+		point_type now = clock::now( );
 
 		auto diff = now - before_;
 
@@ -18,6 +18,7 @@
 #define LIBQ_TYPE_TRAITS_CORE_HPP
 
 #include <ciso646>
+#include <cstdint>
 #include <type_traits>
 #include <tuple>
 #include <memory>
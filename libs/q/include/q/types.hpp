@@ -18,6 +18,7 @@
 #define LIBQ_TYPES_HPP
 
 #include <q/pp.hpp>
+#include <q/fwd.hpp>
 #include <q/function.hpp>
 
 #include <memory>
@@ -25,9 +26,6 @@
 #include <string>
 #include <sstream>
 
-// TODO: Remove this in favor of proper logging
-#include <iostream>
-
 namespace q {
 
 #define Q_HERE \
@@ -129,30 +127,11 @@ private:
 	macro_function::type function_;
 };
 
-class threadpool;
-
-class queue;
-typedef std::shared_ptr< queue > queue_ptr;
-
-class scheduler;
-
 typedef int priority_t;
 
 typedef q::unique_function< void( void ) noexcept > task;
 typedef q::function< void( void ) noexcept > shared_task;
 
-// Execution context
-
-class execution_context;
-typedef std::shared_ptr< execution_context > execution_context_ptr;
-
-template< typename Dispatcher >
-class specific_execution_context;
-
-template< typename Dispatcher >
-using specific_execution_context_ptr =
-	std::shared_ptr< specific_execution_context< Dispatcher > >;
-
 } // namespace q
 
 #endif // LIBQ_TYPES_HPP
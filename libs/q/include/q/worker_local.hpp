@@ -0,0 +1,234 @@
+/*
+ * Copyright 2017 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_WORKER_LOCAL_HPP
+#define LIBQ_WORKER_LOCAL_HPP
+
+#include <q/event_dispatcher.hpp>
+#include <q/this_task.hpp>
+#include <q/mutex.hpp>
+#include <q/memory.hpp>
+#include <q/function.hpp>
+#include <q/exception.hpp>
+
+#include <vector>
+#include <memory>
+
+namespace q {
+
+Q_MAKE_SIMPLE_EXCEPTION( not_a_worker_exception );
+
+namespace detail {
+
+template< typename T >
+class worker_local_state
+: public std::enable_shared_from_this< worker_local_state< T > >
+{
+public:
+	typedef q::function< std::unique_ptr< T >( ) > factory_type;
+
+	worker_local_state(
+		const basic_event_dispatcher* dispatcher,
+		std::size_t parallelism,
+		factory_type&& factory
+	)
+	: dispatcher_( dispatcher )
+	, factory_( std::move( factory ) )
+	, mutex_( Q_HERE, "worker_local" )
+	, instances_( parallelism )
+	{ }
+
+	T& local( )
+	{
+		auto index = current_worker_index( dispatcher_ );
+
+		if ( index < 0 )
+			Q_THROW( not_a_worker_exception( ) );
+
+		// The instance of a worker is only ever set and reset by the
+		// worker itself, so it can be read without the lock
+		auto& instance = instances_[ index ];
+
+		if ( !instance )
+			construct( static_cast< std::size_t >( index ) );
+
+		return *instance;
+	}
+
+	template< typename R, typename Fn >
+	R aggregate( R init, Fn&& fn ) const
+	{
+		Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+		for ( auto& instance : instances_ )
+			if ( instance )
+				init = fn( std::move( init ), *instance );
+
+		return init;
+	}
+
+	std::size_t size( ) const
+	{
+		Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+		std::size_t count = 0;
+		for ( auto& instance : instances_ )
+			if ( instance )
+				++count;
+
+		return count;
+	}
+
+private:
+	void construct( std::size_t index )
+	{
+		auto instance = factory_( );
+
+		{
+			Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+			instances_[ index ] = std::move( instance );
+		}
+
+		std::weak_ptr< worker_local_state > weak_self =
+			this->shared_from_this( );
+
+		at_worker_exit( [ weak_self, index ]( ) noexcept
+		{
+			auto self = weak_self.lock( );
+			if ( self )
+				self->destruct( index );
+		} );
+	}
+
+	void destruct( std::size_t index ) noexcept
+	{
+		std::unique_ptr< T > instance;
+
+		{
+			Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+			instance = std::move( instances_[ index ] );
+		}
+	}
+
+	const basic_event_dispatcher* dispatcher_;
+	factory_type factory_;
+	mutable mutex mutex_;
+	std::vector< std::unique_ptr< T > > instances_;
+};
+
+} // namespace detail
+
+/**
+ * A worker_local< T > holds one instance of T per worker thread of an event
+ * dispatcher (such as a threadpool), e.g. scratch buffers, random number
+ * generators, caches or sharded counters, which can then be used without
+ * synchronization between the workers.
+ *
+ * The instances are constructed lazily, the first time local( ) is called on
+ * each worker, and destructed on that worker when its dispatcher terminates
+ * (or when the last copy of the worker_local is destructed, if earlier).
+ *
+ * aggregate( ) folds all instances, e.g. to sum sharded counters. It may run
+ * concurrently with the workers using their instances, so for values which
+ * are modified while aggregated, T should be e.g. an atomic.
+ *
+ * Only event dispatchers which register their threads' indexes (like the
+ * threadpool) are supported.
+ */
+template< typename T >
+class worker_local
+{
+	typedef detail::worker_local_state< T > state_type;
+
+public:
+	typedef typename state_type::factory_type factory_type;
+
+	/**
+	 * Constructs the worker-local instances using @c factory, which may be
+	 * called concurrently by the workers.
+	 */
+	template< typename Dispatcher >
+	worker_local(
+		const std::shared_ptr< Dispatcher >& dispatcher,
+		factory_type factory
+	)
+	: state_( std::make_shared< state_type >(
+		static_cast< const basic_event_dispatcher* >(
+			dispatcher.get( ) ),
+		dispatcher->parallelism( ),
+		std::move( factory ) ) )
+	{ }
+
+	/**
+	 * Default-constructs the worker-local instances.
+	 */
+	template< typename Dispatcher >
+	explicit worker_local( const std::shared_ptr< Dispatcher >& dispatcher )
+	: worker_local( dispatcher, [ ]( )
+	{
+		return q::make_unique< T >( );
+	} )
+	{ }
+
+	/**
+	 * Returns the instance of the current worker, which is constructed if
+	 * necessary. Throws not_a_worker_exception if not called from a worker
+	 * thread of the dispatcher.
+	 */
+	T& local( )
+	{
+		return state_->local( );
+	}
+
+	T& operator*( )
+	{
+		return local( );
+	}
+
+	T* operator->( )
+	{
+		return &local( );
+	}
+
+	/**
+	 * Folds all constructed instances, by calling
+	 * fn( R accumulated, const T& instance ) -> R for each of them,
+	 * starting with @c init.
+	 */
+	template< typename R, typename Fn >
+	R aggregate( R init, Fn&& fn ) const
+	{
+		return state_->aggregate(
+			std::move( init ), std::forward< Fn >( fn ) );
+	}
+
+	/**
+	 * The number of instances currently constructed.
+	 */
+	std::size_t size( ) const
+	{
+		return state_->size( );
+	}
+
+private:
+	std::shared_ptr< state_type > state_;
+};
+
+} // namespace q
+
+#endif // LIBQ_WORKER_LOCAL_HPP
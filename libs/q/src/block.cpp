@@ -16,6 +16,7 @@
 
 #include <q/block.hpp>
 #include <q/exception.hpp>
+#include <q/memory_budget.hpp>
 
 #include <cstring>
 #include <algorithm>
@@ -78,6 +79,27 @@ byte_block::byte_block(
 , ptr_( data_.get( ) )
 { }
 
+byte_block::byte_block(
+	std::size_t size,
+	std::shared_ptr< const std::uint8_t > data,
+	memory_reservation&& reservation
+)
+: size_( size )
+, ptr_( data.get( ) )
+{
+	struct holder
+	{
+		std::shared_ptr< const std::uint8_t > data;
+		memory_reservation reservation;
+	};
+
+	auto ptr = data.get( );
+	auto held = std::make_shared< holder >(
+		holder{ std::move( data ), std::move( reservation ) } );
+
+	data_ = std::shared_ptr< const std::uint8_t >( std::move( held ), ptr );
+}
+
 byte_block::byte_block(
 	std::size_t offset,
 	std::size_t size,
@@ -2,6 +2,7 @@
 #include <q/blocking_dispatcher.hpp>
 #include <q/mutex.hpp>
 #include <q/time_set.hpp>
+#include <q/this_task.hpp>
 
 #include <queue>
 
@@ -19,6 +20,7 @@ struct blocking_dispatcher::pimpl
 	, started_( false )
 	, running_( false )
 	, stop_asap_( false )
+	, backlog_( 0 )
 	{ }
 
 	std::string name_;
@@ -31,6 +33,8 @@ struct blocking_dispatcher::pimpl
 	task_fetcher_task task_fetcher_;
 	task scheduler_unloader_;
 	time_set< task > timer_tasks_;
+	std::atomic< std::ptrdiff_t > backlog_;
+	dispatcher_statistics statistics_;
 };
 
 blocking_dispatcher::blocking_dispatcher(
@@ -47,6 +51,8 @@ blocking_dispatcher::~blocking_dispatcher( )
 
 void blocking_dispatcher::notify( )
 {
+	pimpl_->backlog_.fetch_add( 1, std::memory_order_relaxed );
+
 	Q_UNIQUE_LOCK( pimpl_->mutex_ );
 	pimpl_->cond_.notify_one( );
 }
@@ -82,8 +88,11 @@ void blocking_dispatcher::start( )
 
 			if ( task )
 			{
+				++pimpl_->statistics_.tasks;
+
 				Q_AUTO_UNIQUE_UNLOCK( lock );
 
+				detail::begin_task( &pimpl_->backlog_ );
 				task( );
 
 				continue;
@@ -97,20 +106,27 @@ void blocking_dispatcher::start( )
 		if ( !pimpl_->running_ && !_task )
 			break;
 
+		if ( _task )
+			pimpl_->backlog_.fetch_sub( 1, std::memory_order_relaxed );
+
 		if ( _task.is_timed( ) )
 		{
 			// We just add the timed task and re-iterate.
 			// This handling needs a complete overhaul. TODO
 			pimpl_->timer_tasks_.push(
 				std::move( _task.wait_until_ ),
-				std::move( _task.task_ ) );
+				std::move( _task.task_ ),
+				_task.slack_ );
 
 			continue;
 		}
 		else if ( _task )
 		{
+			++pimpl_->statistics_.tasks;
+
 			Q_AUTO_UNIQUE_UNLOCK( lock );
 
+			detail::begin_task( &pimpl_->backlog_ );
 			_task.task_( );
 
 			continue;
@@ -122,15 +138,26 @@ void blocking_dispatcher::start( )
 			{
 				auto next = pimpl_->timer_tasks_.next_time( );
 
-				pimpl_->cond_.wait_for( lock, next );
+				auto status = pimpl_->cond_.wait_for( lock, next );
+				++pimpl_->statistics_.wakeups;
+				if ( status == std::cv_status::timeout )
+					++pimpl_->statistics_.timer_wakeups;
 				continue;
 			}
 			pimpl_->cond_.wait( lock );
+			++pimpl_->statistics_.wakeups;
 		}
 	}
 	while ( true );
 }
 
+dispatcher_statistics blocking_dispatcher::statistics( ) const
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+	return pimpl_->statistics_;
+}
+
 void blocking_dispatcher::do_terminate( termination method )
 {
 	{
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2016 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <q/clock.hpp>
+#include <q/pp.hpp>
+
+#include <thread>
+
+#ifdef LIBQ_ON_LINUX
+#	include <time.h>
+#endif
+
+#if defined( __x86_64__ ) || defined( __i386__ ) || \
+	defined( LIBQ_ON_X64 ) || defined( LIBQ_ON_X86 )
+#	define LIBQ_WITH_TSC
+#	ifdef LIBQ_ON_WINDOWS
+#		include <intrin.h>
+#	else
+#		include <x86intrin.h>
+#	endif
+#endif
+
+namespace q {
+
+namespace {
+
+#if defined( LIBQ_ON_LINUX ) && defined( CLOCK_MONOTONIC_COARSE )
+
+steady_clock::duration coarse_resolution( )
+{
+	struct timespec ts;
+
+	if ( ::clock_getres( CLOCK_MONOTONIC_COARSE, &ts ) )
+		return steady_clock::duration::max( );
+
+	return std::chrono::duration_cast< steady_clock::duration >(
+		std::chrono::seconds( ts.tv_sec ) +
+		std::chrono::nanoseconds( ts.tv_nsec ) );
+}
+
+#endif
+
+#ifdef LIBQ_WITH_TSC
+
+struct tsc_calibration
+{
+	tsc_calibration( )
+	{
+		// Measure the counter against steady_clock during a short period,
+		// enough for a sub-percent error.
+		auto start_time = steady_clock::now( );
+		base_ = __rdtsc( );
+
+		std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+
+		auto end_time = steady_clock::now( );
+		auto end = __rdtsc( );
+
+		auto elapsed = std::chrono::duration_cast< std::chrono::nanoseconds >(
+			end_time - start_time );
+
+		ns_per_tick_ = end > base_
+			? double( elapsed.count( ) ) / double( end - base_ )
+			: 0;
+	}
+
+	unsigned long long base_;
+	double ns_per_tick_;
+};
+
+const tsc_calibration& get_tsc_calibration( )
+{
+	static const tsc_calibration calibration;
+	return calibration;
+}
+
+#endif
+
+} // anonymous namespace
+
+coarse_clock::time_point coarse_clock::now( ) noexcept
+{
+#if defined( LIBQ_ON_LINUX ) && defined( CLOCK_MONOTONIC_COARSE )
+	struct timespec ts;
+
+	if ( !::clock_gettime( CLOCK_MONOTONIC_COARSE, &ts ) )
+		return time_point( std::chrono::duration_cast< duration >(
+			std::chrono::seconds( ts.tv_sec ) +
+			std::chrono::nanoseconds( ts.tv_nsec ) ) );
+#endif
+
+	return steady_clock::now( );
+}
+
+coarse_clock::duration coarse_clock::resolution( ) noexcept
+{
+#if defined( LIBQ_ON_LINUX ) && defined( CLOCK_MONOTONIC_COARSE )
+	static const duration resolution = coarse_resolution( );
+	return resolution;
+#else
+	return duration::zero( );
+#endif
+}
+
+tsc_clock::time_point tsc_clock::now( ) noexcept
+{
+#ifdef LIBQ_WITH_TSC
+	auto& calibration = get_tsc_calibration( );
+
+	if ( calibration.ns_per_tick_ > 0 )
+		return time_point( duration( static_cast< rep >(
+			double( __rdtsc( ) - calibration.base_ ) *
+			calibration.ns_per_tick_ ) ) );
+#endif
+
+	return time_point( std::chrono::duration_cast< duration >(
+		steady_clock::now( ).time_since_epoch( ) ) );
+}
+
+bool tsc_clock::is_native( ) noexcept
+{
+#ifdef LIBQ_WITH_TSC
+	return get_tsc_calibration( ).ns_per_tick_ > 0;
+#else
+	return false;
+#endif
+}
+
+steady_clock::time_point now_within( steady_clock::duration accuracy ) noexcept
+{
+	if ( coarse_clock::resolution( ) * 2 <= accuracy )
+		return coarse_clock::now( );
+
+	return steady_clock::now( );
+}
+
+} // namespace q
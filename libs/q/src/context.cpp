@@ -0,0 +1,81 @@
+/*
+ * Copyright 2017 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <q/context.hpp>
+
+namespace q {
+
+namespace {
+
+static thread_local context_ptr current_context_;
+
+/**
+ * A task bound to the context in which it was scheduled, which is restored
+ * while the task runs.
+ */
+struct contextual_task
+{
+	context_ptr context_;
+	task task_;
+
+	void operator( )( ) noexcept
+	{
+		context_scope scope( std::move( context_ ) );
+
+		task_( );
+	}
+};
+
+} // anonymous namespace
+
+const context_ptr& context::current( ) noexcept
+{
+	return current_context_;
+}
+
+const void* context::find( const void* key ) const noexcept
+{
+	for ( auto ctx = this; ctx; ctx = ctx->parent_.get( ) )
+		if ( ctx->key_ == key )
+			return ctx->value_;
+
+	return nullptr;
+}
+
+context_scope::context_scope( context_ptr ctx ) noexcept
+: previous_( std::move( ctx ) )
+{
+	current_context_.swap( previous_ );
+}
+
+context_scope::~context_scope( )
+{
+	current_context_.swap( previous_ );
+}
+
+namespace detail {
+
+task with_current_context( task&& fn )
+{
+	if ( !current_context_ )
+		return std::move( fn );
+
+	return contextual_task{ current_context_, std::move( fn ) };
+}
+
+} // namespace detail
+
+} // namespace q
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2017 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <q/credit.hpp>
+#include <q/mutex.hpp>
+
+#include <deque>
+
+namespace q {
+
+credit::credit( )
+{ }
+
+credit::credit( std::shared_ptr< credit_pool > pool )
+: pool_( std::move( pool ) )
+{ }
+
+credit::credit( credit&& other )
+: pool_( std::move( other.pool_ ) )
+{ }
+
+credit::~credit( )
+{
+	release( );
+}
+
+credit& credit::operator=( credit&& other )
+{
+	if ( this != &other )
+	{
+		release( );
+
+		pool_ = std::move( other.pool_ );
+	}
+
+	return *this;
+}
+
+credit::operator bool( ) const
+{
+	return !!pool_;
+}
+
+void credit::release( )
+{
+	auto pool = std::move( pool_ );
+
+	if ( pool )
+		pool->release( );
+}
+
+struct credit_pool::pimpl
+{
+	pimpl( std::size_t credits )
+	: mutex_( Q_HERE, "credit_pool" )
+	, credits_( credits )
+	, in_flight_( 0 )
+	{ }
+
+	// Must be called with the mutex locked
+	bool available( ) const
+	{
+		return in_flight_ < credits_;
+	}
+
+	mutable mutex mutex_;
+	std::size_t credits_;
+	std::size_t in_flight_;
+	std::deque< std::shared_ptr< detail::defer< credit > > > waiters_;
+};
+
+credit_pool::credit_pool( std::size_t credits )
+: pimpl_( new pimpl( credits ) )
+{ }
+
+credit_pool::~credit_pool( )
+{ }
+
+std::shared_ptr< credit_pool >
+credit_pool::construct( std::size_t credits )
+{
+	return ::q::make_shared_using_constructor< credit_pool >( credits );
+}
+
+void credit_pool::set_credits( std::size_t credits )
+{
+	{
+		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+		pimpl_->credits_ = credits;
+	}
+
+	update( );
+}
+
+std::size_t credit_pool::credits( ) const
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+	return pimpl_->credits_;
+}
+
+std::size_t credit_pool::in_flight( ) const
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+	return pimpl_->in_flight_;
+}
+
+std::size_t credit_pool::waiting( ) const
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+	return pimpl_->waiters_.size( );
+}
+
+promise< credit > credit_pool::acquire( const queue_ptr& queue )
+{
+	auto deferred = detail::defer< credit >::construct( queue );
+
+	{
+		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+		if ( !pimpl_->waiters_.empty( ) || !pimpl_->available( ) )
+		{
+			pimpl_->waiters_.push_back( deferred );
+
+			return deferred->get_promise( );
+		}
+
+		++pimpl_->in_flight_;
+	}
+
+	deferred->set_value( std::make_tuple( credit( shared_from_this( ) ) ) );
+
+	return deferred->get_promise( );
+}
+
+credit credit_pool::try_acquire( )
+{
+	{
+		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+		if ( !pimpl_->waiters_.empty( ) || !pimpl_->available( ) )
+			return credit( );
+
+		++pimpl_->in_flight_;
+	}
+
+	return credit( shared_from_this( ) );
+}
+
+void credit_pool::release( )
+{
+	{
+		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+		if ( pimpl_->in_flight_ > 0 )
+			--pimpl_->in_flight_;
+	}
+
+	update( );
+}
+
+void credit_pool::update( )
+{
+	std::vector< std::shared_ptr< detail::defer< credit > > > granted;
+
+	{
+		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+		while ( !pimpl_->waiters_.empty( ) && pimpl_->available( ) )
+		{
+			granted.push_back(
+				std::move( pimpl_->waiters_.front( ) ) );
+			pimpl_->waiters_.pop_front( );
+
+			++pimpl_->in_flight_;
+		}
+	}
+
+	for ( auto& deferred : granted )
+		deferred->set_value( std::make_tuple(
+			credit( shared_from_this( ) ) ) );
+}
+
+} // namespace q
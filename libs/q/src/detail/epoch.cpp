@@ -0,0 +1,277 @@
+/*
+ * Copyright 2016 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "epoch.hpp"
+
+#include <q/mutex.hpp>
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+namespace q { namespace detail { namespace epoch {
+
+namespace {
+
+// The number of retired pointers a thread collects before flushing
+const std::size_t batch_size = 64;
+
+struct retired
+{
+	void* ptr;
+	deleter_type deleter;
+	std::uint64_t epoch;
+};
+
+/**
+ * A participant is the per-thread state. They are linked together in a list
+ * which only grows; when a thread exits, its participant is released and can
+ * be reused by a new thread.
+ */
+struct participant
+{
+	participant( )
+	: state( 0 )
+	, in_use( true )
+	, next( nullptr )
+	, nesting( 0 )
+	{ }
+
+	// ( epoch << 1 ) | 1 while pinned, otherwise 0
+	std::atomic< std::uint64_t > state;
+	std::atomic< bool > in_use;
+	participant* next;
+
+	// Only accessed by the owning thread
+	std::size_t nesting;
+	std::vector< retired > retired_list;
+};
+
+struct domain
+{
+	domain( )
+	: epoch( 1 )
+	, participants( nullptr )
+	, orphans_mutex( Q_HERE, "epoch orphans" )
+	{ }
+
+	std::atomic< std::uint64_t > epoch;
+	std::atomic< participant* > participants;
+
+	// Retired pointers left behind by exited threads
+	mutex orphans_mutex;
+	std::vector< retired > orphans;
+};
+
+domain& get_domain( )
+{
+	// Intentionally leaked, as it must outlive all thread_local
+	// registrations, including those destructed after static destruction.
+	static domain* d = new domain;
+	return *d;
+}
+
+participant* acquire_participant( )
+{
+	auto& d = get_domain( );
+
+	auto p = d.participants.load( std::memory_order_acquire );
+	for ( ; p; p = p->next )
+	{
+		bool expected = false;
+		if (
+			!p->in_use.load( std::memory_order_relaxed ) &&
+			p->in_use.compare_exchange_strong(
+				expected, true, std::memory_order_acquire )
+		)
+			return p;
+	}
+
+	p = new participant;
+
+	auto head = d.participants.load( std::memory_order_relaxed );
+	do
+	{
+		p->next = head;
+	}
+	while ( !d.participants.compare_exchange_weak(
+		head, p, std::memory_order_release, std::memory_order_relaxed ) );
+
+	return p;
+}
+
+bool try_advance( domain& d )
+{
+	auto epoch = d.epoch.load( std::memory_order_acquire );
+
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+
+	auto p = d.participants.load( std::memory_order_acquire );
+	for ( ; p; p = p->next )
+	{
+		auto state = p->state.load( std::memory_order_acquire );
+
+		if ( ( state & 1 ) && ( state >> 1 ) != epoch )
+			return false;
+	}
+
+	return d.epoch.compare_exchange_strong(
+		epoch, epoch + 1, std::memory_order_acq_rel );
+}
+
+/**
+ * Removes the pointers which are safe to delete at @c epoch from @c list,
+ * and returns them. They are deleted by the caller, after having released any
+ * locks, as deleters may retire more pointers.
+ */
+std::vector< retired >
+extract_reclaimable( std::vector< retired >& list, std::uint64_t epoch )
+{
+	auto safe = std::partition(
+		list.begin( ), list.end( ),
+		[ epoch ]( const retired& r )
+		{
+			return r.epoch + 2 > epoch;
+		} );
+
+	std::vector< retired > reclaimable( safe, list.end( ) );
+	list.erase( safe, list.end( ) );
+
+	return reclaimable;
+}
+
+void reclaim( std::vector< retired >&& reclaimable )
+{
+	for ( auto& r : reclaimable )
+		r.deleter( r.ptr );
+}
+
+void flush_orphans( domain& d, std::uint64_t epoch )
+{
+	std::vector< retired > reclaimable;
+
+	{
+		Q_AUTO_UNIQUE_LOCK( d.orphans_mutex );
+
+		if ( d.orphans.empty( ) )
+			return;
+
+		reclaimable = extract_reclaimable( d.orphans, epoch );
+	}
+
+	reclaim( std::move( reclaimable ) );
+}
+
+struct registration
+{
+	registration( )
+	: self( acquire_participant( ) )
+	{ }
+
+	~registration( )
+	{
+		auto& d = get_domain( );
+
+		try_advance( d );
+		auto epoch = d.epoch.load( std::memory_order_acquire );
+		reclaim( extract_reclaimable( self->retired_list, epoch ) );
+
+		if ( !self->retired_list.empty( ) )
+		{
+			Q_AUTO_UNIQUE_LOCK( d.orphans_mutex );
+
+			d.orphans.insert(
+				d.orphans.end( ),
+				self->retired_list.begin( ),
+				self->retired_list.end( ) );
+		}
+
+		self->retired_list.clear( );
+		self->retired_list.shrink_to_fit( );
+		self->nesting = 0;
+		self->state.store( 0, std::memory_order_release );
+		self->in_use.store( false, std::memory_order_release );
+	}
+
+	participant* self;
+};
+
+participant& local( )
+{
+	static thread_local registration registration_;
+	return *registration_.self;
+}
+
+} // anonymous namespace
+
+guard::guard( )
+{
+	auto& self = local( );
+
+	if ( self.nesting++ == 0 )
+	{
+		auto epoch = get_domain( ).epoch.load( std::memory_order_relaxed );
+		self.state.store( ( epoch << 1 ) | 1, std::memory_order_relaxed );
+
+		// The announcement must be visible before any shared pointer is
+		// read by this thread
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+	}
+}
+
+guard::~guard( )
+{
+	auto& self = local( );
+
+	if ( --self.nesting == 0 )
+		self.state.store( 0, std::memory_order_release );
+}
+
+void retire( void* ptr, deleter_type deleter )
+{
+	auto& self = local( );
+	auto epoch = get_domain( ).epoch.load( std::memory_order_seq_cst );
+
+	self.retired_list.push_back( retired{ ptr, deleter, epoch } );
+
+	if ( self.retired_list.size( ) >= batch_size )
+		flush( );
+}
+
+void flush( )
+{
+	auto& d = get_domain( );
+	auto& self = local( );
+
+	try_advance( d );
+
+	auto epoch = d.epoch.load( std::memory_order_acquire );
+
+	reclaim( extract_reclaimable( self.retired_list, epoch ) );
+	flush_orphans( d, epoch );
+}
+
+std::size_t pending( )
+{
+	return local( ).retired_list.size( );
+}
+
+std::uint64_t current( )
+{
+	return get_domain( ).epoch.load( std::memory_order_acquire );
+}
+
+} } } // namespace epoch, namespace detail, namespace q
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2016 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBQ_INTERNAL_EPOCH_HPP
+#define LIBQ_INTERNAL_EPOCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace q {
+
+namespace detail {
+
+/**
+ * Epoch-based memory reclamation, for lock-free data structures.
+ *
+ * Readers pin the current thread (with an epoch_guard) while they access
+ * shared nodes. Writers unlink nodes and retire them, rather than deleting
+ * them. A retired node is deleted once the global epoch has advanced twice,
+ * at which point no pinned thread can still reference it.
+ *
+ * Threads register lazily on their first use, and unregister when they exit.
+ * This covers q::thread and the threadpool workers. Retired nodes of exited
+ * threads are handed over to the next thread which flushes.
+ */
+namespace epoch {
+
+typedef void ( *deleter_type )( void* );
+
+/**
+ * Pins the current thread to the current epoch during its lifetime. Guards
+ * can be nested.
+ */
+class guard
+{
+public:
+	guard( );
+	~guard( );
+
+	guard( const guard& ) = delete;
+	guard& operator=( const guard& ) = delete;
+};
+
+/**
+ * Retires @c ptr, which will be deleted with @c deleter when no pinned thread
+ * can reference it anymore. Retired pointers are flushed in batches.
+ */
+void retire( void* ptr, deleter_type deleter );
+
+template< typename T >
+void retire( T* ptr )
+{
+	retire(
+		static_cast< void* >( ptr ),
+		[ ]( void* p ) { delete static_cast< T* >( p ); } );
+}
+
+/**
+ * Tries to advance the global epoch, and deletes the retired pointers of the
+ * current thread (and of exited threads) which are safe to delete.
+ */
+void flush( );
+
+/**
+ * The number of pointers retired by the current thread, not yet deleted.
+ */
+std::size_t pending( );
+
+/**
+ * The current global epoch.
+ */
+std::uint64_t current( );
+
+} // namespace epoch
+
+} // namespace detail
+
+} // namespace q
+
+#endif // LIBQ_INTERNAL_EPOCH_HPP
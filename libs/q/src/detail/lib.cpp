@@ -19,6 +19,7 @@
 #include <q/detail/lib.hpp>
 
 #include <atomic>
+#include <iostream>
 
 #ifdef _WIN32
 #	include <q/detail/platform/windows.hpp>
@@ -0,0 +1,334 @@
+/*
+ * Copyright 2013 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <q/dispatcher_controller.hpp>
+#include <q/queue.hpp>
+#include <q/mutex.hpp>
+#include <q/memory.hpp>
+
+#include <algorithm>
+
+namespace q {
+
+namespace {
+
+typedef std::chrono::duration< double > seconds_type;
+
+dispatcher_tunables adjust(
+	const dispatcher_tunables& current,
+	const dispatcher_controller::decision& sample,
+	const dispatcher_controller::bounds& bounds
+)
+{
+	dispatcher_tunables next = current;
+
+	const bool waiting = sample.wait > bounds.target_wait;
+	const bool idle = sample.utilization < bounds.low_utilization;
+
+	// Threads
+	if ( waiting || sample.utilization > bounds.high_utilization )
+		next.active_threads = current.active_threads + 1;
+	else if ( idle && current.active_threads > 0 )
+		next.active_threads = current.active_threads - 1;
+
+	next.active_threads = std::max( bounds.min_threads,
+		std::min( next.active_threads, bounds.max_threads ) );
+
+	// Batch size
+	if ( waiting )
+		next.batch_size = current.batch_size * 2;
+	else if ( sample.wait < bounds.target_wait / 4 )
+		next.batch_size = current.batch_size / 2;
+
+	next.batch_size = std::max( bounds.min_batch_size,
+		std::min( next.batch_size, bounds.max_batch_size ) );
+
+	// Spin window. Spinning doesn't count as being busy, so it's reduced
+	// when the threads are mostly idle, and increased when (busy) threads
+	// often need to be woken up.
+	const timer::duration_type min_spin = std::chrono::microseconds( 1 );
+
+	if ( idle )
+		next.spin = current.spin / 2;
+	else if ( sample.wakeups_per_task > 0.5 )
+		next.spin = current.spin < min_spin
+			? min_spin
+			: current.spin * 2;
+
+	if ( next.spin < min_spin )
+		next.spin = timer::duration_type::zero( );
+	next.spin = std::min( next.spin, bounds.max_spin );
+
+	return next;
+}
+
+bool operator!=( const dispatcher_tunables& a, const dispatcher_tunables& b )
+{
+	return a.active_threads != b.active_threads
+		|| a.batch_size != b.batch_size
+		|| a.spin != b.spin;
+}
+
+} // anonymous namespace
+
+dispatcher_controller::bounds::bounds( )
+: min_threads( 1 )
+, max_threads( 0 )
+, min_batch_size( 1 )
+, max_batch_size( 32 )
+, max_spin( std::chrono::microseconds( 50 ) )
+, target_wait( std::chrono::milliseconds( 1 ) )
+, low_utilization( 0.3 )
+, high_utilization( 0.85 )
+, interval( std::chrono::milliseconds( 100 ) )
+{ }
+
+struct dispatcher_controller::pimpl
+{
+	pimpl( std::shared_ptr< tunable_event_dispatcher > dispatcher,
+	       const queue_ptr& queue,
+	       const queue_ptr& control_queue,
+	       bounds limits,
+	       metrics_function metrics )
+	: dispatcher_( std::move( dispatcher ) )
+	, queue_( queue )
+	, control_queue_( control_queue )
+	, bounds_( std::move( limits ) )
+	, metrics_( std::move( metrics ) )
+	, mutex_( Q_HERE, "dispatcher_controller mutex" )
+	, running_( false )
+	, probing_( false )
+	, wait_( timer::duration_type::zero( ) )
+	{ }
+
+	std::shared_ptr< tunable_event_dispatcher > dispatcher_;
+	queue_ptr                                   queue_;
+	queue_ptr                                   control_queue_;
+	bounds                                      bounds_;
+	metrics_function                            metrics_;
+	mutex                                       mutex_;
+	bool                                        running_;
+	bool                                        probing_;
+	timer::point_type                           probe_sent_;
+	timer::duration_type                        wait_;
+	timer::point_type                           last_time_;
+	dispatcher_statistics                       last_statistics_;
+	decision                                    last_decision_;
+};
+
+std::shared_ptr< dispatcher_controller >
+dispatcher_controller::construct(
+	std::shared_ptr< tunable_event_dispatcher > dispatcher,
+	const queue_ptr& queue,
+	const queue_ptr& control_queue,
+	bounds limits,
+	metrics_function metrics )
+{
+	return ::q::make_shared_using_constructor< dispatcher_controller >(
+		std::move( dispatcher ),
+		queue,
+		control_queue,
+		std::move( limits ),
+		std::move( metrics ) );
+}
+
+dispatcher_controller::dispatcher_controller(
+	std::shared_ptr< tunable_event_dispatcher > dispatcher,
+	const queue_ptr& queue,
+	const queue_ptr& control_queue,
+	bounds limits,
+	metrics_function metrics )
+: pimpl_( new pimpl(
+	std::move( dispatcher ),
+	queue,
+	control_queue,
+	std::move( limits ),
+	std::move( metrics ) ) )
+{
+	auto& dispatcher_ = pimpl_->dispatcher_;
+	auto& bounds_ = pimpl_->bounds_;
+
+	auto tunables = dispatcher_->tunables( );
+
+	if ( bounds_.max_threads == 0 )
+		bounds_.max_threads = tunables.active_threads;
+	bounds_.min_threads = std::max< std::size_t >(
+		1, std::min( bounds_.min_threads, bounds_.max_threads ) );
+	bounds_.min_batch_size = std::max< std::size_t >(
+		1, bounds_.min_batch_size );
+	bounds_.max_batch_size = std::max(
+		bounds_.min_batch_size, bounds_.max_batch_size );
+
+	dispatcher_->collect_statistics( true );
+
+	pimpl_->last_time_ = timer::point_type::clock::now( );
+	pimpl_->last_statistics_ = dispatcher_->statistics( );
+
+	auto& last = pimpl_->last_decision_;
+	last.time = pimpl_->last_time_;
+	last.wait = timer::duration_type::zero( );
+	last.utilization = 0;
+	last.wakeups_per_task = 0;
+	last.throughput = 0;
+	last.previous = tunables;
+	last.tunables = tunables;
+}
+
+dispatcher_controller::~dispatcher_controller( )
+{
+	pimpl_->dispatcher_->collect_statistics( false );
+}
+
+void dispatcher_controller::start( )
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+	if ( pimpl_->running_ )
+		return;
+
+	pimpl_->running_ = true;
+
+	schedule( );
+}
+
+void dispatcher_controller::stop( )
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+	pimpl_->running_ = false;
+}
+
+dispatcher_controller::decision dispatcher_controller::sample( )
+{
+	decision sample;
+	metrics_function metrics;
+
+	{
+		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+		auto& dispatcher_ = pimpl_->dispatcher_;
+		auto& last = pimpl_->last_statistics_;
+
+		auto now = timer::point_type::clock::now( );
+		auto statistics = dispatcher_->statistics( );
+		auto current = dispatcher_->tunables( );
+
+		auto seconds = std::chrono::duration_cast< seconds_type >(
+			now - pimpl_->last_time_ ).count( );
+		auto busy = std::chrono::duration_cast< seconds_type >(
+			statistics.busy - last.busy ).count( );
+		auto tasks = statistics.tasks - last.tasks;
+		auto wakeups = statistics.wakeups - last.wakeups;
+
+		// An outstanding probe has waited at least until now
+		sample.wait = pimpl_->probing_
+			? std::max( pimpl_->wait_, now - pimpl_->probe_sent_ )
+			: pimpl_->wait_;
+
+		sample.time = now;
+		sample.utilization = seconds > 0
+			? busy / ( seconds * current.active_threads )
+			: 0;
+		sample.wakeups_per_task = tasks > 0
+			? static_cast< double >( wakeups ) / tasks
+			: 0;
+		sample.throughput = seconds > 0 ? tasks / seconds : 0;
+		sample.previous = current;
+		sample.tunables = adjust( current, sample, pimpl_->bounds_ );
+
+		if ( sample.tunables != current )
+		{
+			dispatcher_->set_tunables( sample.tunables );
+			sample.tunables = dispatcher_->tunables( );
+		}
+
+		pimpl_->last_time_ = now;
+		pimpl_->last_statistics_ = statistics;
+		pimpl_->last_decision_ = sample;
+
+		if ( !pimpl_->probing_ )
+			probe( );
+
+		metrics = pimpl_->metrics_;
+	}
+
+	if ( metrics )
+		metrics( sample );
+
+	return sample;
+}
+
+dispatcher_controller::decision dispatcher_controller::last_decision( ) const
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+	return pimpl_->last_decision_;
+}
+
+void dispatcher_controller::schedule( )
+{
+	std::weak_ptr< dispatcher_controller > weak_self = shared_from_this( );
+
+	auto next = timer::point_type::clock::now( ) + pimpl_->bounds_.interval;
+
+	pimpl_->control_queue_->push( [ weak_self ]( )
+	{
+		auto self = weak_self.lock( );
+		if ( !self )
+			return;
+
+		{
+			Q_AUTO_UNIQUE_LOCK( self->pimpl_->mutex_ );
+
+			if ( !self->pimpl_->running_ )
+				return;
+		}
+
+		self->sample( );
+
+		Q_AUTO_UNIQUE_LOCK( self->pimpl_->mutex_ );
+
+		if ( self->pimpl_->running_ )
+			self->schedule( );
+	}, next );
+}
+
+// Must be called with the mutex locked
+void dispatcher_controller::probe( )
+{
+	std::weak_ptr< dispatcher_controller > weak_self = shared_from_this( );
+
+	auto sent = timer::point_type::clock::now( );
+
+	pimpl_->probing_ = true;
+	pimpl_->probe_sent_ = sent;
+
+	pimpl_->queue_->push( [ weak_self, sent ]( )
+	{
+		auto now = timer::point_type::clock::now( );
+
+		auto self = weak_self.lock( );
+		if ( !self )
+			return;
+
+		Q_AUTO_UNIQUE_LOCK( self->pimpl_->mutex_ );
+
+		self->pimpl_->wait_ = now - sent;
+		self->pimpl_->probing_ = false;
+	} );
+}
+
+} // namespace q
@@ -15,6 +15,7 @@
  */
 
 #include <q/exception/exception.hpp>
+#include <q/exception/cached.hpp>
 
 #include <unordered_map>
 #include <vector>
@@ -62,7 +63,7 @@ struct specific_errno_thrower
 	}
 	std::exception_ptr ptr( ) const override
 	{
-		return std::make_exception_ptr( exception( ) );
+		return ::q::cached_exception< exception >( );
 	}
 };
 
@@ -132,6 +133,11 @@ namespace q {
 
 std::exception_ptr get_exception_by_errno( int errno_ )
 {
+	// Known errno values are data-free exceptions, which are cached
+	auto iter = get_errno_map( )->map.find( errno_ );
+	if ( iter != get_errno_map( )->map.end( ) )
+		return iter->second->ptr( );
+
 	try
 	{
 		throw_by_errno( errno_ );
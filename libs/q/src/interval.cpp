@@ -0,0 +1,125 @@
+/*
+ * Copyright 2016 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <q/interval.hpp>
+
+namespace q { namespace detail {
+
+struct periodic_timer::pimpl
+{
+	pimpl( const queue_ptr& queue,
+	       timer::duration_type period,
+	       tick_policy policy,
+	       tick_function fn )
+	: queue_( queue )
+	, period_( period )
+	, policy_( policy )
+	, fn_( std::move( fn ) )
+	, stopped_( false )
+	{ }
+
+	queue_ptr queue_;
+	const timer::duration_type period_;
+	const tick_policy policy_;
+	tick_function fn_;
+	timer::point_type next_;
+	std::atomic< bool > stopped_;
+};
+
+std::shared_ptr< periodic_timer >
+periodic_timer::construct( const queue_ptr& queue,
+                           timer::duration_type period,
+                           tick_policy policy,
+                           tick_function fn )
+{
+	return ::q::make_shared_using_constructor< periodic_timer >(
+		queue, period, policy, std::move( fn ) );
+}
+
+periodic_timer::periodic_timer( const queue_ptr& queue,
+                                timer::duration_type period,
+                                tick_policy policy,
+                                tick_function fn )
+: pimpl_( new pimpl( queue, period, policy, std::move( fn ) ) )
+{ }
+
+periodic_timer::~periodic_timer( )
+{ }
+
+void periodic_timer::start( )
+{
+	pimpl_->next_ = timer::point_type::clock::now( ) + pimpl_->period_;
+
+	schedule( );
+}
+
+void periodic_timer::stop( )
+{
+	pimpl_->stopped_.store( true, std::memory_order_release );
+}
+
+void periodic_timer::schedule( )
+{
+	auto self = shared_from_this( );
+
+	pimpl_->queue_->push( [ self ]( )
+	{
+		self->fire( );
+	}, pimpl_->next_ );
+}
+
+// Only one tick task exists at a time, so fire() never runs concurrently
+void periodic_timer::fire( )
+{
+	auto& next = pimpl_->next_;
+	auto& period = pimpl_->period_;
+
+	auto stopped = [ this ]( )
+	{
+		return pimpl_->stopped_.load( std::memory_order_acquire );
+	};
+
+	if ( stopped( ) )
+		return;
+
+	auto now = timer::point_type::clock::now( );
+
+	if ( pimpl_->policy_ == tick_policy::catch_up )
+	{
+		do
+		{
+			if ( !pimpl_->fn_( next ) )
+				return stop( );
+
+			next += period;
+		}
+		while ( next <= now && !stopped( ) );
+	}
+	else
+	{
+		if ( !pimpl_->fn_( next ) )
+			return stop( );
+
+		// Advance to the first period boundary after now
+		auto missed = ( now - next ) / period;
+		next += period * ( missed + 1 );
+	}
+
+	if ( !stopped( ) )
+		schedule( );
+}
+
+} } // namespace detail, namespace q
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2017 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <q/log.hpp>
+
+#include <iostream>
+
+namespace q { namespace detail {
+
+void perform_logging::log( const macro_location& location,
+                           const std::unique_ptr< logtype_adapter >& adapter,
+                           const std::string& msg )
+{
+	std::cout
+		<< adapter->string( ) << " "
+		<< location.string( ) << ": "
+		<< msg;
+}
+
+} } // namespace detail, namespace q
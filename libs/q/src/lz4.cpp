@@ -0,0 +1,445 @@
+/*
+ * Copyright 2017 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <q/lz4.hpp>
+#include <q/endian.hpp>
+#include <q/mutex.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace q { namespace lz4 {
+
+namespace {
+
+// The last match must start at least this many bytes before the end
+constexpr std::size_t mf_limit = 12;
+
+// The last bytes of a block are always literals
+constexpr std::size_t last_literals = 5;
+
+constexpr std::size_t min_match = 4;
+constexpr std::size_t max_distance = 0xFFFF;
+
+constexpr unsigned hash_log = 12;
+constexpr std::size_t hash_size = std::size_t( 1 ) << hash_log;
+
+// Skips ahead faster through incompressible data
+constexpr unsigned skip_trigger = 6;
+
+inline std::uint32_t read32( const std::uint8_t* p ) noexcept
+{
+	std::uint32_t value;
+	std::memcpy( &value, p, sizeof value );
+	return value;
+}
+
+inline std::uint32_t hash( std::uint32_t sequence ) noexcept
+{
+	return ( sequence * 2654435761U ) >> ( 32 - hash_log );
+}
+
+inline std::uint8_t* write_length( std::uint8_t* op, std::size_t length )
+{
+	while ( length >= 255 )
+	{
+		*op++ = 255;
+		length -= 255;
+	}
+	*op++ = static_cast< std::uint8_t >( length );
+	return op;
+}
+
+inline std::uint8_t* write_sequence(
+	std::uint8_t* op,
+	const std::uint8_t* literals, std::size_t literal_length,
+	std::size_t offset, std::size_t match_length
+)
+{
+	std::uint8_t* token = op++;
+
+	if ( literal_length >= 15 )
+	{
+		*token = 15 << 4;
+		op = write_length( op, literal_length - 15 );
+	}
+	else
+		*token = static_cast< std::uint8_t >( literal_length << 4 );
+
+	std::memcpy( op, literals, literal_length );
+	op += literal_length;
+
+	// The last literals are written without any match
+	if ( !match_length )
+		return op;
+
+	*op++ = static_cast< std::uint8_t >( offset );
+	*op++ = static_cast< std::uint8_t >( offset >> 8 );
+
+	match_length -= min_match;
+
+	if ( match_length >= 15 )
+	{
+		*token |= 15;
+		op = write_length( op, match_length - 15 );
+	}
+	else
+		*token |= static_cast< std::uint8_t >( match_length );
+
+	return op;
+}
+
+/**
+ * Reads an extended length (of literals or a match) from @c ip, and adds it
+ * to @c length.
+ */
+inline const std::uint8_t* read_length(
+	const std::uint8_t* ip, const std::uint8_t* end, std::size_t& length )
+{
+	std::uint8_t byte;
+	do
+	{
+		if ( ip >= end )
+			Q_THROW( corrupt_data_exception( ) );
+
+		byte = *ip++;
+		length += byte;
+	}
+	while ( byte == 255 );
+
+	return ip;
+}
+
+/**
+ * A pool of output buffers, in power-of-two size classes. Buffers are handed
+ * out as shared pointers which return them to the pool when the last
+ * byte_block referring to them is destructed.
+ */
+class buffer_pool
+{
+public:
+	buffer_pool( )
+	: mutex_( Q_HERE, "lz4 buffer_pool" )
+	{ }
+
+	std::shared_ptr< std::uint8_t > get( std::size_t size )
+	{
+		auto size_class = class_of( size );
+
+		if ( size_class >= num_classes )
+			return std::shared_ptr< std::uint8_t >(
+				new std::uint8_t[ size ],
+				std::default_delete< std::uint8_t[ ] >( ) );
+
+		std::uint8_t* buffer = nullptr;
+
+		{
+			Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+			auto& free = free_[ size_class ];
+			if ( !free.empty( ) )
+			{
+				buffer = free.back( );
+				free.pop_back( );
+			}
+		}
+
+		if ( !buffer )
+			buffer = new std::uint8_t[ size_of( size_class ) ];
+
+		return std::shared_ptr< std::uint8_t >(
+			buffer,
+			[ this, size_class ]( std::uint8_t* buffer )
+			{
+				put( size_class, buffer );
+			} );
+	}
+
+private:
+	static constexpr std::size_t min_class_log = 12; // 4 KiB
+	static constexpr std::size_t num_classes = 11; // up to 4 MiB
+	static constexpr std::size_t max_free = 16;
+
+	static std::size_t class_of( std::size_t size )
+	{
+		std::size_t size_class = 0;
+		while (
+			size_class < num_classes &&
+			size_of( size_class ) < size
+		)
+			++size_class;
+		return size_class;
+	}
+
+	static std::size_t size_of( std::size_t size_class )
+	{
+		return std::size_t( 1 ) << ( min_class_log + size_class );
+	}
+
+	void put( std::size_t size_class, std::uint8_t* buffer )
+	{
+		{
+			Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+			auto& free = free_[ size_class ];
+			if ( free.size( ) < max_free )
+			{
+				free.push_back( buffer );
+				return;
+			}
+		}
+
+		delete[ ] buffer;
+	}
+
+	mutex mutex_;
+	std::vector< std::uint8_t* > free_[ num_classes ];
+};
+
+// Never destructed, as blocks may outlive static destruction
+buffer_pool& buffers( )
+{
+	static buffer_pool* pool = new buffer_pool( );
+	return *pool;
+}
+
+constexpr std::size_t size_prefix = sizeof( std::uint32_t );
+
+byte_block compress_contiguous( const std::uint8_t* src, std::size_t size )
+{
+	if ( size > max_block_size )
+		Q_THROW( std::out_of_range(
+			"lz4::compress block is too large" ) );
+
+	auto capacity = size_prefix + compress_bound( size );
+	auto buffer = buffers( ).get( capacity );
+
+	le< std::uint32_t > prefix( static_cast< std::uint32_t >( size ) );
+	std::memcpy( buffer.get( ), &prefix, size_prefix );
+
+	auto compressed = compress(
+		src, size,
+		buffer.get( ) + size_prefix, capacity - size_prefix );
+
+	return byte_block(
+		size_prefix + compressed,
+		std::shared_ptr< const std::uint8_t >( std::move( buffer ) ) );
+}
+
+} // anonymous namespace
+
+std::size_t compress(
+	const std::uint8_t* src, std::size_t size,
+	std::uint8_t* dst, std::size_t capacity
+)
+{
+	if ( capacity < compress_bound( size ) )
+		Q_THROW( std::out_of_range(
+			"lz4::compress needs compress_bound( size ) bytes" ) );
+
+	std::uint8_t* op = dst;
+	std::size_t anchor = 0;
+
+	if ( size >= mf_limit + 1 )
+	{
+		std::uint32_t table[ hash_size ];
+		std::memset( table, 0, sizeof table );
+
+		const std::size_t match_start_limit = size - mf_limit;
+		const std::size_t match_end_limit = size - last_literals;
+
+		// Position 0 is stored as is, so the table is always valid
+		std::size_t ip = 1;
+		std::size_t attempts = 1 << skip_trigger;
+
+		table[ hash( read32( src ) ) ] = 0;
+
+		while ( ip <= match_start_limit )
+		{
+			auto sequence = read32( src + ip );
+			auto& slot = table[ hash( sequence ) ];
+			std::size_t ref = slot;
+			slot = static_cast< std::uint32_t >( ip );
+
+			if (
+				ip - ref > max_distance ||
+				read32( src + ref ) != sequence
+			)
+			{
+				ip += attempts++ >> skip_trigger;
+				continue;
+			}
+
+			attempts = 1 << skip_trigger;
+
+			// Extend the match backwards into pending literals
+			while ( ip > anchor && ref > 0 && src[ ip - 1 ] == src[ ref - 1 ] )
+			{
+				--ip;
+				--ref;
+			}
+
+			std::size_t length = min_match;
+			while (
+				ip + length < match_end_limit &&
+				src[ ref + length ] == src[ ip + length ]
+			)
+				++length;
+
+			op = write_sequence(
+				op, src + anchor, ip - anchor, ip - ref, length );
+
+			ip += length;
+			anchor = ip;
+
+			// Improves the ratio for repetitive data
+			if ( ip - 2 <= match_start_limit )
+				table[ hash( read32( src + ip - 2 ) ) ] =
+					static_cast< std::uint32_t >( ip - 2 );
+		}
+	}
+
+	op = write_sequence( op, src + anchor, size - anchor, 0, 0 );
+
+	return op - dst;
+}
+
+std::size_t decompress(
+	const std::uint8_t* src, std::size_t size,
+	std::uint8_t* dst, std::size_t capacity
+)
+{
+	const std::uint8_t* ip = src;
+	const std::uint8_t* const end = src + size;
+	std::uint8_t* op = dst;
+	std::uint8_t* const op_end = dst + capacity;
+
+	while ( true )
+	{
+		if ( ip >= end )
+			Q_THROW( corrupt_data_exception( ) );
+
+		const std::uint8_t token = *ip++;
+
+		std::size_t literal_length = token >> 4;
+		if ( literal_length == 15 )
+			ip = read_length( ip, end, literal_length );
+
+		if (
+			literal_length > static_cast< std::size_t >( end - ip ) ||
+			literal_length > static_cast< std::size_t >( op_end - op )
+		)
+			Q_THROW( corrupt_data_exception( ) );
+
+		std::memcpy( op, ip, literal_length );
+		ip += literal_length;
+		op += literal_length;
+
+		// The last sequence has no match
+		if ( ip == end )
+			break;
+
+		if ( end - ip < 2 )
+			Q_THROW( corrupt_data_exception( ) );
+
+		std::size_t offset = ip[ 0 ] | ( ip[ 1 ] << 8 );
+		ip += 2;
+
+		if ( !offset || offset > static_cast< std::size_t >( op - dst ) )
+			Q_THROW( corrupt_data_exception( ) );
+
+		std::size_t match_length = token & 15;
+		if ( match_length == 15 )
+			ip = read_length( ip, end, match_length );
+		match_length += min_match;
+
+		if ( match_length > static_cast< std::size_t >( op_end - op ) )
+			Q_THROW( corrupt_data_exception( ) );
+
+		const std::uint8_t* match = op - offset;
+
+		if ( offset >= match_length )
+		{
+			std::memcpy( op, match, match_length );
+			op += match_length;
+		}
+		else
+		{
+			// Overlapping, i.e. a repeating pattern
+			for ( std::size_t i = 0; i < match_length; ++i )
+				*op++ = *match++;
+		}
+	}
+
+	return op - dst;
+}
+
+byte_block compress( const byte_block& block )
+{
+	return compress_contiguous( block.data( ), block.size( ) );
+}
+
+byte_block compress( const std::vector< byte_block >& blocks )
+{
+	if ( blocks.size( ) == 1 )
+		return compress( blocks.front( ) );
+
+	std::size_t size = 0;
+	for ( auto& block : blocks )
+		size += block.size( );
+
+	// LZ4 matches need a contiguous window, so the chain is gathered
+	auto gathered = buffers( ).get( size );
+
+	std::size_t offset = 0;
+	for ( auto& block : blocks )
+	{
+		std::memcpy( gathered.get( ) + offset, block.data( ), block.size( ) );
+		offset += block.size( );
+	}
+
+	return compress_contiguous( gathered.get( ), size );
+}
+
+byte_block decompress( const byte_block& block )
+{
+	if ( block.size( ) < size_prefix )
+		Q_THROW( corrupt_data_exception( ) );
+
+	le< std::uint32_t > prefix;
+	std::memcpy( &prefix, block.data( ), size_prefix );
+	std::size_t size = prefix;
+
+	// Every input byte expands to at most 255 output bytes, which guards
+	// against allocating for absurd sizes in corrupt data
+	auto payload = block.size( ) - size_prefix;
+	if ( size > max_block_size || size > payload * 255 + 64 )
+		Q_THROW( corrupt_data_exception( ) );
+
+	auto buffer = buffers( ).get( size );
+
+	auto decompressed = decompress(
+		block.data( ) + size_prefix, block.size( ) - size_prefix,
+		buffer.get( ), size );
+
+	if ( decompressed != size )
+		Q_THROW( corrupt_data_exception( ) );
+
+	return byte_block(
+		size, std::shared_ptr< const std::uint8_t >( std::move( buffer ) ) );
+}
+
+} } // namespace lz4, namespace q
@@ -0,0 +1,306 @@
+/*
+ * Copyright 2016 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <q/memory_budget.hpp>
+#include <q/mutex.hpp>
+
+#include <deque>
+#include <algorithm>
+#include <list>
+
+namespace q {
+
+constexpr std::size_t memory_budget::unlimited;
+
+memory_reservation::memory_reservation( )
+: bytes_( 0 )
+{ }
+
+memory_reservation::memory_reservation(
+	std::shared_ptr< memory_budget > budget, std::size_t bytes
+)
+: budget_( std::move( budget ) )
+, bytes_( bytes )
+{ }
+
+memory_reservation::memory_reservation( memory_reservation&& other )
+: budget_( std::move( other.budget_ ) )
+, bytes_( other.bytes_ )
+{
+	other.bytes_ = 0;
+}
+
+memory_reservation::~memory_reservation( )
+{
+	release( );
+}
+
+memory_reservation&
+memory_reservation::operator=( memory_reservation&& other )
+{
+	if ( this != &other )
+	{
+		release( );
+
+		budget_ = std::move( other.budget_ );
+		bytes_ = other.bytes_;
+		other.bytes_ = 0;
+	}
+
+	return *this;
+}
+
+std::size_t memory_reservation::bytes( ) const
+{
+	return bytes_;
+}
+
+memory_reservation::operator bool( ) const
+{
+	return !!budget_;
+}
+
+void memory_reservation::release( )
+{
+	if ( budget_ )
+		budget_->release( bytes_ );
+
+	budget_.reset( );
+	bytes_ = 0;
+}
+
+struct memory_budget::pimpl
+{
+	pimpl( std::size_t limit )
+	: mutex_( Q_HERE, "memory_budget" )
+	, limit_( limit )
+	, used_( 0 )
+	, next_listener_id_( 1 )
+	{ }
+
+	struct waiter
+	{
+		std::size_t bytes;
+		std::shared_ptr< detail::defer< memory_reservation > > deferred;
+	};
+
+	// Must be called with the mutex locked
+	bool fits( std::size_t bytes ) const
+	{
+		return used_ == 0 || ( used_ < limit_ && bytes <= limit_ - used_ );
+	}
+
+	// Must be called with the mutex locked
+	bool exhausted( ) const
+	{
+		return used_ >= limit_;
+	}
+
+	mutable mutex mutex_;
+	std::size_t limit_;
+	std::size_t used_;
+	std::deque< waiter > waiters_;
+	listener_id next_listener_id_;
+	std::list< std::pair< listener_id, shared_task > > listeners_;
+};
+
+memory_budget::memory_budget( std::size_t limit )
+: pimpl_( new pimpl( limit ) )
+{ }
+
+memory_budget::~memory_budget( )
+{ }
+
+std::shared_ptr< memory_budget >
+memory_budget::construct( std::size_t limit )
+{
+	return ::q::make_shared_using_constructor< memory_budget >( limit );
+}
+
+std::shared_ptr< memory_budget > memory_budget::global( )
+{
+	static std::shared_ptr< memory_budget > budget = construct( unlimited );
+	return budget;
+}
+
+void memory_budget::set_limit( std::size_t limit )
+{
+	{
+		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+		pimpl_->limit_ = limit;
+	}
+
+	// Grants waiters and notifies listeners if the limit was raised
+	update( 0, true );
+}
+
+std::size_t memory_budget::limit( ) const
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+	return pimpl_->limit_;
+}
+
+std::size_t memory_budget::used( ) const
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+	return pimpl_->used_;
+}
+
+std::size_t memory_budget::waiting( ) const
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+	return pimpl_->waiters_.size( );
+}
+
+bool memory_budget::exhausted( ) const
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+	return pimpl_->exhausted( );
+}
+
+promise< memory_reservation >
+memory_budget::reserve( const queue_ptr& queue, std::size_t bytes )
+{
+	auto deferred = detail::defer< memory_reservation >::construct( queue );
+
+	{
+		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+		if ( !pimpl_->waiters_.empty( ) || !pimpl_->fits( bytes ) )
+		{
+			pimpl_->waiters_.push_back(
+				pimpl::waiter{ bytes, deferred } );
+
+			return deferred->get_promise( );
+		}
+
+		pimpl_->used_ += bytes;
+	}
+
+	deferred->set_value( std::make_tuple(
+		memory_reservation( shared_from_this( ), bytes ) ) );
+
+	return deferred->get_promise( );
+}
+
+memory_reservation memory_budget::try_reserve( std::size_t bytes )
+{
+	{
+		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+		if ( !pimpl_->waiters_.empty( ) || !pimpl_->fits( bytes ) )
+			return memory_reservation( );
+
+		pimpl_->used_ += bytes;
+	}
+
+	return memory_reservation( shared_from_this( ), bytes );
+}
+
+memory_reservation memory_budget::force_reserve( std::size_t bytes )
+{
+	{
+		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+		pimpl_->used_ += bytes;
+	}
+
+	return memory_reservation( shared_from_this( ), bytes );
+}
+
+memory_budget::listener_id memory_budget::add_listener( shared_task fn )
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+	auto id = pimpl_->next_listener_id_++;
+	pimpl_->listeners_.emplace_back( id, std::move( fn ) );
+
+	return id;
+}
+
+void memory_budget::remove_listener( listener_id id )
+{
+	shared_task removed;
+
+	{
+		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+		auto& listeners = pimpl_->listeners_;
+		for ( auto iter = listeners.begin( ); iter != listeners.end( ); )
+		{
+			if ( iter->first == id )
+			{
+				removed = std::move( iter->second );
+				iter = listeners.erase( iter );
+			}
+			else
+				++iter;
+		}
+	}
+}
+
+void memory_budget::release( std::size_t bytes )
+{
+	update( bytes, false );
+}
+
+void memory_budget::update( std::size_t released, bool limit_changed )
+{
+	std::vector< pimpl::waiter > granted;
+	std::vector< shared_task > notifications;
+
+	{
+		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+		bool was_exhausted = pimpl_->exhausted( );
+
+		pimpl_->used_ -= std::min( released, pimpl_->used_ );
+
+		// Strictly FIFO, so that large reservations don't starve
+		while (
+			!pimpl_->waiters_.empty( ) &&
+			pimpl_->fits( pimpl_->waiters_.front( ).bytes )
+		)
+		{
+			auto waiter = std::move( pimpl_->waiters_.front( ) );
+			pimpl_->waiters_.pop_front( );
+
+			pimpl_->used_ += waiter.bytes;
+			granted.push_back( std::move( waiter ) );
+		}
+
+		if (
+			( was_exhausted || limit_changed ) &&
+			!pimpl_->exhausted( )
+		)
+			for ( auto& listener : pimpl_->listeners_ )
+				notifications.push_back( listener.second );
+	}
+
+	for ( auto& waiter : granted )
+		waiter.deferred->set_value( std::make_tuple( memory_reservation(
+			shared_from_this( ), waiter.bytes ) ) );
+
+	for ( auto& notification : notifications )
+		notification( );
+}
+
+} // namespace q
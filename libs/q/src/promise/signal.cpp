@@ -16,8 +16,10 @@
 
 #include <q/promise/signal.hpp>
 
+#include <q/context.hpp>
 #include <q/mutex.hpp>
 #include <q/queue.hpp>
+#include <q/detail/stress.hpp>
 
 namespace q { namespace detail {
 
@@ -35,8 +37,11 @@ struct item
 	task task_;
 	queue_ptr queue_;
 	bool synchronous_;
+	bool resolver_affinity_;
 };
 
+static thread_local bool resolver_affinity_ = false;
+
 } // anonymous namespace
 
 struct promise_signal::pimpl
@@ -65,10 +70,15 @@ void promise_signal::done( ) noexcept
 		pimpl_->done_ = true;
 	}
 
+	Q_STRESS_POINT( "promise_signal::done" );
+
 	for ( auto& item : pimpl_->items_ )
 	{
 		if ( item.synchronous_ )
 			item.task_( );
+		else if ( item.resolver_affinity_ )
+			item.queue_->push(
+				std::move( item.task_ ), affinity::resolver );
 		else
 			item.queue_->push( std::move( item.task_ ) );
 	}
@@ -78,18 +88,24 @@ void promise_signal::done( ) noexcept
 
 void promise_signal::push( task&& task, const queue_ptr& queue ) noexcept
 {
+	// Continuations run within the context they were registered in
+	task = detail::with_current_context( std::move( task ) );
+
 	{
 		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
 
 		if ( !pimpl_->done_ )
 		{
-			pimpl_->items_.push_back(
-				{ std::move( task ), queue, false } );
+			pimpl_->items_.push_back( {
+				std::move( task ), queue, false, resolver_affinity_
+			} );
 
 			return;
 		}
 	}
 
+	Q_STRESS_POINT( "promise_signal::push" );
+
 	queue->push( std::move( task ) );
 }
 
@@ -101,13 +117,26 @@ void promise_signal::push_synchronous( task&& task ) noexcept
 		if ( !pimpl_->done_ )
 		{
 			pimpl_->items_.push_back(
-				{ std::move( task ), nullptr, true } );
+				{ std::move( task ), nullptr, true, false } );
 
 			return;
 		}
 	}
 
+	Q_STRESS_POINT( "promise_signal::push_synchronous" );
+
 	task( );
 }
 
+resolver_affinity_scope::resolver_affinity_scope( ) noexcept
+: previous_( resolver_affinity_ )
+{
+	resolver_affinity_ = true;
+}
+
+resolver_affinity_scope::~resolver_affinity_scope( )
+{
+	resolver_affinity_ = previous_;
+}
+
 } } // namespace detail, namespace queue
@@ -18,11 +18,30 @@
 #include <q/mutex.hpp>
 #include <q/memory.hpp>
 #include <q/exception.hpp>
+#include <q/this_task.hpp>
+#include <q/detail/stress.hpp>
 
 #include <queue>
+#include <algorithm>
+#include <atomic>
 
 namespace q {
 
+namespace {
+
+// Index of the highest set bit, for each bitmap of the priority classes
+static const std::uint8_t highest_priority_class[ 16 ] = {
+	0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3
+};
+
+static_assert(
+	queue::num_priority_classes == 4,
+	"highest_priority_class must cover all priority classes" );
+
+} // anonymous namespace
+
+constexpr std::size_t queue::num_priority_classes;
+
 // TODO: Consider using a semaphore instead, and then preferably a non-locking
 // queue altogether. The only thing necessary is that two push-calls from the
 // same thread must follow order.
@@ -32,13 +51,21 @@ struct queue::pimpl
 	: priority_( priority )
 	, mutex_( Q_HERE, "queue mutex" )
 	, parallelism_( 1 )
+	, non_empty_( 0 )
+	, dispatcher_( nullptr )
+	, timer_slack_( timer::duration_type::zero( ) )
 	{ }
 
 	const priority_t priority_;
 	mutex mutex_;
 	queue::notify_type notify_;
 	std::size_t parallelism_;
-	std::queue< task > queue_;
+	std::atomic< const basic_event_dispatcher* > dispatcher_;
+	timer::duration_type timer_slack_;
+	// One sub-queue per priority class, and a bitmap of which of them are
+	// non-empty.
+	std::queue< task > queues_[ queue::num_priority_classes ];
+	std::uint8_t non_empty_;
 	std::queue< timer_task > timer_task_queue_;
 };
 
@@ -57,60 +84,119 @@ queue::~queue( )
 }
 
 void queue::push( task&& task )
+{
+	push( std::move( task ), priority_class::normal );
+}
+
+void queue::push( task&& task, priority_class priority )
 {
 	notify_type notifyer;
 
 	{
 		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_, Q_HERE, "queue::push" );
 
-		pimpl_->queue_.push( std::move( task ) );
+		auto level = static_cast< std::size_t >( priority );
+
+		pimpl_->queues_[ level ].push( std::move( task ) );
+		pimpl_->non_empty_ |= 1 << level;
 
 		notifyer = pimpl_->notify_;
 	}
 
+	Q_STRESS_POINT( "queue::push" );
+
 	if ( notifyer )
 		notifyer( );
 }
 
+void queue::push( task&& task, affinity::resolver_t )
+{
+	auto dispatcher = pimpl_->dispatcher_.load( std::memory_order_acquire );
+
+	if ( dispatcher )
+		// Swaps the task with the one in the slot, if accepted
+		detail::push_to_local_slot( dispatcher, task );
+
+	if ( task )
+		push( std::move( task ) );
+}
+
 void queue::push( task&& task, timer::point_type wait_until )
 {
-	notify_type notifyer;
+	timer::duration_type slack;
 
 	{
 		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_, Q_HERE, "queue::push(2)" );
 
-		timer_task tt( std::move( task ), std::move( wait_until ) );
+		slack = pimpl_->timer_slack_;
+	}
+
+	push( std::move( task ), std::move( wait_until ), slack );
+}
+
+void queue::push( task&& task,
+                  timer::point_type wait_until,
+                  timer::duration_type slack )
+{
+	notify_type notifyer;
+
+	{
+		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_, Q_HERE, "queue::push(3)" );
+
+		timer_task tt(
+			std::move( task ), std::move( wait_until ), slack );
 		pimpl_->timer_task_queue_.push( std::move( tt ) );
 
 		notifyer = pimpl_->notify_;
 	}
 
+	Q_STRESS_POINT( "queue::push(3)" );
+
 	if ( notifyer )
 		notifyer( );
 }
 
+void queue::set_timer_slack( timer::duration_type slack )
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_, Q_HERE, "queue::set_timer_slack" );
+
+	pimpl_->timer_slack_ = std::max( timer::duration_type::zero( ), slack );
+}
+
+timer::duration_type queue::timer_slack( ) const
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_, Q_HERE, "queue::timer_slack" );
+
+	return pimpl_->timer_slack_;
+}
+
 priority_t queue::priority( ) const
 {
 	return pimpl_->priority_;
 }
 
-void queue::set_consumer( queue::notify_type fn, std::size_t parallelism )
+void queue::set_consumer( queue::notify_type fn,
+                          std::size_t parallelism,
+                          const basic_event_dispatcher* dispatcher )
 {
 	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_, Q_HERE, "queue::set_consumer" );
 
 	pimpl_->notify_ = fn;
 	pimpl_->parallelism_ = parallelism;
+	pimpl_->dispatcher_.store( dispatcher, std::memory_order_release );
 }
 
 bool queue::empty( )
 {
 	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_, Q_HERE, "queue::empty" );
 
-	return pimpl_->queue_.empty( ) && pimpl_->timer_task_queue_.empty( );
+	return !pimpl_->non_empty_ && pimpl_->timer_task_queue_.empty( );
 }
 
 timer_task queue::pop( )
 {
+	Q_STRESS_POINT( "queue::pop" );
+
 	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_, Q_HERE, "queue::pop" );
 
 	if ( !pimpl_->timer_task_queue_.empty( ) )
@@ -122,12 +208,18 @@ timer_task queue::pop( )
 		return task;
 	}
 
-	if ( pimpl_->queue_.empty( ) )
+	if ( !pimpl_->non_empty_ )
 		return timer_task( );
 
-	timer_task task = std::move( pimpl_->queue_.front( ) );
+	auto level = highest_priority_class[ pimpl_->non_empty_ ];
+	auto& queue = pimpl_->queues_[ level ];
+
+	timer_task task = std::move( queue.front( ) );
+
+	queue.pop( );
 
-	pimpl_->queue_.pop( );
+	if ( queue.empty( ) )
+		pimpl_->non_empty_ &= ~( 1 << level );
 
 	return task;
 }
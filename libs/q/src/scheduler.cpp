@@ -232,7 +232,7 @@ void priority_scheduler::add_queue( queue_ptr queue )
 			ed->notify( );
 		else
 		{ } // TODO: Warn or error somehow
-	}, ed->parallelism( ) );
+	}, ed->parallelism( ), ed.get( ) );
 
 	auto _this = shared_from_this( );
 
@@ -291,7 +291,7 @@ void direct_scheduler::add_queue( queue_ptr queue )
 				ed->notify( );
 			else
 			{ } // TODO: Warn or error somehow
-		}, ed->parallelism( ) );
+		}, ed->parallelism( ), ed.get( ) );
 	}
 	else
 	{
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2016 Gustaf Räntilä
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <q/this_task.hpp>
+
+#include <vector>
+
+namespace q {
+
+namespace {
+
+struct current_task
+{
+	// Incremented for each task run on this thread
+	std::size_t generation;
+
+	// The generation for which start was recorded
+	std::size_t started_generation;
+	timer::point_type start;
+
+	const std::atomic< std::ptrdiff_t >* backlog;
+};
+
+static thread_local current_task current_task_ = {
+	1, 0, timer::point_type( ), nullptr
+};
+
+struct current_worker
+{
+	const basic_event_dispatcher* dispatcher;
+	detail::local_slot* slot;
+	std::size_t index;
+};
+
+static thread_local current_worker current_worker_ = { nullptr, nullptr, 0 };
+
+static thread_local std::vector< task >* worker_exit_functions_ = nullptr;
+
+} // anonymous namespace
+
+namespace detail {
+
+void set_local_slot(
+	const basic_event_dispatcher* dispatcher,
+	local_slot* slot,
+	std::size_t index ) noexcept
+{
+	current_worker_.dispatcher = slot ? dispatcher : nullptr;
+	current_worker_.slot = slot;
+	current_worker_.index = index;
+}
+
+std::ptrdiff_t current_worker_index(
+	const basic_event_dispatcher* dispatcher ) noexcept
+{
+	if ( !current_worker_.slot || current_worker_.dispatcher != dispatcher )
+		return -1;
+
+	return static_cast< std::ptrdiff_t >( current_worker_.index );
+}
+
+void at_worker_exit( task&& fn )
+{
+	if ( !worker_exit_functions_ )
+		worker_exit_functions_ = new std::vector< task >( );
+
+	worker_exit_functions_->push_back( std::move( fn ) );
+}
+
+void worker_exit( ) noexcept
+{
+	std::unique_ptr< std::vector< task > > functions(
+		worker_exit_functions_ );
+	worker_exit_functions_ = nullptr;
+
+	if ( !functions )
+		return;
+
+	for ( auto iter = functions->rbegin( ); iter != functions->rend( );
+		++iter )
+		( *iter )( );
+}
+
+void push_to_local_slot(
+	const basic_event_dispatcher* dispatcher, task& task ) noexcept
+{
+	if ( current_worker_.slot && current_worker_.dispatcher == dispatcher )
+		current_worker_.slot->swap_in( task );
+}
+
+void begin_task( const std::atomic< std::ptrdiff_t >* backlog ) noexcept
+{
+	++current_task_.generation;
+	current_task_.backlog = backlog;
+}
+
+} // namespace detail
+
+namespace this_task {
+
+bool should_yield( timer::duration_type time_slice )
+{
+	auto& current = current_task_;
+
+	if ( current.started_generation != current.generation )
+	{
+		current.started_generation = current.generation;
+		current.start = now_within( time_slice / 4 );
+		return false;
+	}
+
+	if (
+		current.backlog &&
+		current.backlog->load( std::memory_order_relaxed ) <= 0
+	)
+		return false;
+
+	// The time slice doesn't need to be exact, so use a cheaper clock if
+	// it's accurate enough
+	auto now = now_within( time_slice / 4 );
+
+	return now - current.start > time_slice;
+}
+
+} // namespace this_task
+
+} // namespace q
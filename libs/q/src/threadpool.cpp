@@ -17,12 +17,14 @@
 #include <q/threadpool.hpp>
 #include <q/mutex.hpp>
 #include <q/time_set.hpp>
+#include <q/this_task.hpp>
 
 #include <thread>
 #include <queue>
 #include <condition_variable>
 #include <sstream>
 #include <set>
+#include <algorithm>
 
 namespace q {
 
@@ -54,7 +56,41 @@ struct threadpool::pimpl
 	, started_( false )
 	, running_( false )
 	, stop_asap_( false )
-	{ }
+	, collect_statistics_( false )
+	, backlog_( 0 )
+	{
+		tunables_.active_threads = threads;
+		slots_.resize( threads );
+	}
+
+	/**
+	 * The local slot of a worker thread, to which tasks pushed with
+	 * affinity::resolver by the thread itself are put.
+	 */
+	struct worker_slot
+	: detail::local_slot
+	{
+		worker_slot( pimpl& owner, std::size_t index )
+		: owner_( owner )
+		, index_( index )
+		{ }
+
+		void swap_in( task& task ) noexcept override
+		{
+			Q_AUTO_UNIQUE_LOCK( owner_.mutex_ );
+
+			std::swap( task, owner_.slots_[ index_ ] );
+
+			// Unless a task was pushed out of the slot (which will
+			// be pushed to the queue), one more task is waiting.
+			if ( !task )
+				owner_.backlog_.fetch_add(
+					1, std::memory_order_relaxed );
+		}
+
+		pimpl& owner_;
+		std::size_t index_;
+	};
 
 	typedef std::shared_ptr< thread< > > thread_type;
 	typedef expect< void >               result_type;
@@ -66,9 +102,15 @@ struct threadpool::pimpl
 	std::size_t                num_threads_;
 	std::vector< thread_type > threads_;
 	std::condition_variable    cond_;
+	std::condition_variable    park_cond_;
 	bool                       started_;
 	bool                       running_;
 	bool                       stop_asap_;
+	bool                       collect_statistics_;
+	dispatcher_tunables        tunables_;
+	dispatcher_statistics      statistics_;
+	std::atomic< std::ptrdiff_t > backlog_;
+	std::vector< task >        slots_;
 	task_fetcher_task          task_fetcher_;
 	task                       scheduler_unloader_;
 	time_set< task >           timer_tasks_;
@@ -102,6 +144,8 @@ threadpool::construct( const std::string& name,
 
 void threadpool::notify( )
 {
+	pimpl_->backlog_.fetch_add( 1, std::memory_order_relaxed );
+
 	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
 	pimpl_->cond_.notify_one( );
 }
@@ -126,6 +170,47 @@ std::size_t threadpool::parallelism( ) const
 	return pimpl_->num_threads_;
 }
 
+dispatcher_tunables threadpool::tunables( ) const
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+	return pimpl_->tunables_;
+}
+
+void threadpool::set_tunables( const dispatcher_tunables& tunables )
+{
+	{
+		Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+		auto& current = pimpl_->tunables_;
+
+		current.active_threads = std::max< std::size_t >(
+			1, std::min( tunables.active_threads, pimpl_->num_threads_ ) );
+		current.batch_size = std::max< std::size_t >(
+			1, tunables.batch_size );
+		current.spin = std::max(
+			timer::duration_type::zero( ), tunables.spin );
+	}
+
+	// Parked threads re-check whether they are allowed to run
+	pimpl_->park_cond_.notify_all( );
+	pimpl_->cond_.notify_all( );
+}
+
+void threadpool::collect_statistics( bool enable )
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+	pimpl_->collect_statistics_ = enable;
+}
+
+dispatcher_statistics threadpool::statistics( ) const
+{
+	Q_AUTO_UNIQUE_LOCK( pimpl_->mutex_ );
+
+	return pimpl_->statistics_;
+}
+
 promise< > threadpool::start( )
 {
 	auto _this = shared_from_this( );
@@ -144,6 +229,10 @@ promise< > threadpool::start( )
 		{
 			auto& pimpl_ = _this->pimpl_;
 
+			pimpl::worker_slot local_slot( *pimpl_, index );
+			detail::set_local_slot(
+				_this.get( ), &local_slot, index );
+
 			auto lock = Q_UNIQUE_LOCK( pimpl_->mutex_ );
 
 			auto invoker = [ ]( task&& elem )
@@ -159,11 +248,60 @@ promise< > threadpool::start( )
 				}
 			};
 
+			// Tasks are fetched in batches (of the configured
+			// batch size) under the lock, and then run without it.
+			std::vector< task > batch;
+
+			bool spinning = false;
+			timer::point_type spin_until;
+
+			auto run_batch = [ &pimpl_, &lock, &batch, &invoker ]( )
+			{
+				// Busy time is measured with the time-stamp
+				// counter, which is cheap enough per batch
+				bool measure = pimpl_->collect_statistics_;
+				tsc_clock::time_point before, after;
+
+				{
+					Q_AUTO_UNIQUE_UNLOCK( lock );
+
+					if ( measure )
+						before = tsc_clock::now( );
+
+					for ( auto& task : batch )
+					{
+						detail::begin_task(
+							&pimpl_->backlog_ );
+						invoker( std::move( task ) );
+					}
+
+					if ( measure )
+						after = tsc_clock::now( );
+				}
+
+				pimpl_->statistics_.tasks += batch.size( );
+				pimpl_->statistics_.busy += std::chrono::duration_cast<
+					timer::duration_type >( after - before );
+				batch.clear( );
+			};
+
 			do
 			{
 				if ( pimpl_->stop_asap_ )
 					break;
 
+				if (
+					pimpl_->running_ &&
+					index >= pimpl_->tunables_.active_threads
+				)
+				{
+					// This thread is parked until more
+					// threads are allowed to run.
+					spinning = false;
+					pimpl_->park_cond_.wait( lock );
+					continue;
+				}
+
 				if ( pimpl_->timer_tasks_
 					.exists_before_or_at( )
 				)
@@ -172,60 +310,142 @@ promise< > threadpool::start( )
 
 					if ( task )
 					{
-						Q_AUTO_UNIQUE_UNLOCK( lock );
-
-						invoker( std::move( task ) );
+						batch.push_back(
+							std::move( task ) );
+						run_batch( );
 
 						continue;
 					}
 				}
 
-				timer_task _task = pimpl_->task_fetcher_
-					? pimpl_->task_fetcher_( )
-					: timer_task( );
+				auto take_slot = [ &pimpl_, &batch ]( task& slot )
+				{
+					batch.push_back( std::move( slot ) );
+					slot = task( );
+					pimpl_->backlog_.fetch_sub(
+						1, std::memory_order_relaxed );
+				};
+
+				// The task in the local slot of this thread runs
+				// first, while its data is likely still cached.
+				auto& own_slot = pimpl_->slots_[ index ];
+				if ( own_slot )
+					take_slot( own_slot );
+
+				const auto batch_size =
+					pimpl_->tunables_.batch_size;
+
+				while ( batch.size( ) < batch_size )
+				{
+					timer_task _task = pimpl_->task_fetcher_
+						? pimpl_->task_fetcher_( )
+						: timer_task( );
 
-				if ( !pimpl_->running_ && !_task )
-					break;
+					if ( !_task )
+						break;
 
-				if ( _task.is_timed( ) )
-				{
-					// We just add the timed task and re-
-					// iterate.
-					// This handling of timed tasks is
-					// highly inefficient and needs to be
-					// entirely redesigned. TODO
-					pimpl_->timer_tasks_.push(
-						std::move( _task.wait_until_ ),
+					pimpl_->backlog_.fetch_sub(
+						1, std::memory_order_relaxed );
+
+					if ( _task.is_timed( ) )
+					{
+						// We just add the timed task
+						// and continue fetching.
+						// This handling of timed tasks
+						// is highly inefficient and
+						// needs to be entirely
+						// redesigned. TODO
+						pimpl_->timer_tasks_.push(
+							std::move(
+								_task.wait_until_ ),
+							std::move( _task.task_ ),
+							_task.slack_ );
+
+						continue;
+					}
+
+					batch.push_back(
 						std::move( _task.task_ ) );
+				}
+
+				if ( batch.empty( ) )
+				{
+					// Steal from the local slot of another thread
+					for ( auto& slot : pimpl_->slots_ )
+					{
+						if ( slot )
+						{
+							take_slot( slot );
+							break;
+						}
+					}
+				}
 
+				if ( !batch.empty( ) )
+				{
+					spinning = false;
+					run_batch( );
 					continue;
 				}
-				else if ( _task )
+
+				if ( !pimpl_->running_ )
+					break;
+
+				if ( pimpl_->tunables_.spin.count( ) > 0 )
 				{
-					Q_AUTO_UNIQUE_UNLOCK( lock );
+					// Poll for new tasks for a while, before
+					// going to sleep.
+					auto now = timer::point_type::clock::now( );
 
-					invoker( std::move( _task.task_ ) );
+					if ( !spinning )
+					{
+						spinning = true;
+						spin_until =
+							now + pimpl_->tunables_.spin;
+					}
+
+					if ( now < spin_until )
+					{
+						Q_AUTO_UNIQUE_UNLOCK( lock );
+						std::this_thread::yield( );
+						continue;
+					}
 				}
 
-				if ( pimpl_->running_ && !_task )
+				spinning = false;
+
+				if ( !pimpl_->timer_tasks_.empty( ) )
 				{
-					if ( !pimpl_->timer_tasks_.empty( ) )
-					{
-						auto next = pimpl_->timer_tasks_
-							.next_time( );
+					auto next = pimpl_->timer_tasks_
+						.next_time( );
 
-						if ( next != duration_max )
-						{
-							pimpl_->cond_.wait_for(
-								lock, next );
-							continue;
-						}
+					if ( next != duration_max )
+					{
+						auto status = pimpl_->cond_
+							.wait_for( lock, next );
+						++pimpl_->statistics_.wakeups;
+						if ( status ==
+							std::cv_status::timeout )
+							++pimpl_->statistics_
+								.timer_wakeups;
+						continue;
 					}
-					pimpl_->cond_.wait( lock );
 				}
+				pimpl_->cond_.wait( lock );
+				++pimpl_->statistics_.wakeups;
 			}
 			while ( true );
 
+			{
+				// Destructs the worker-local data of this
+				// thread, without the lock held
+				Q_AUTO_UNIQUE_UNLOCK( lock );
+
+				detail::worker_exit( );
+			}
+
+			detail::set_local_slot( nullptr, nullptr );
+
 			_this->mark_completion( );
 		};
 
@@ -259,6 +479,7 @@ promise< > threadpool::start( )
 void threadpool::mark_completion( )
 {
 	pimpl_->cond_.notify_all( );
+	pimpl_->park_cond_.notify_all( );
 }
 
 void threadpool::do_terminate( termination method )
@@ -278,6 +499,7 @@ void threadpool::do_terminate( termination method )
 	}
 
 	pimpl_->cond_.notify_all( );
+	pimpl_->park_cond_.notify_all( );
 }
 
 q::expect< > threadpool::await_termination( )
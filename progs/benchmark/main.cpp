@@ -7,6 +7,9 @@
 #include <q/scheduler.hpp>
 #include <q/timer.hpp>
 
+#include <detail/epoch.hpp>
+
+#include <iostream>
 #include <iomanip>
 #include <numeric>
 
@@ -326,6 +329,75 @@ void benchmark_tasks_on_threadpool( std::size_t iterations, bool parallel )
 	std::cout << std::endl;
 }
 
+void benchmark_reclamation( std::size_t iterations )
+{
+	benchmark_title( "memory reclamation, atomic shared_ptr vs epochs" );
+
+	q::timer::duration_type total_dur( 0 );
+	volatile int sink = 0;
+
+	{
+		auto state = std::make_shared< int >( 1 );
+
+		auto timer_scope = make_benchmark_timer(
+			total_dur, iterations, "Reading with std::atomic_load( shared_ptr )" );
+
+		for ( std::size_t i = 0; i < iterations; ++i )
+		{
+			auto s = std::atomic_load( &state );
+			sink = *s;
+		}
+	}
+
+	{
+		std::atomic< int* > state( new int( 1 ) );
+
+		{
+			auto timer_scope = make_benchmark_timer(
+				total_dur, iterations, "Reading with an epoch guard" );
+
+			for ( std::size_t i = 0; i < iterations; ++i )
+			{
+				q::detail::epoch::guard guard;
+				sink = *state.load( std::memory_order_acquire );
+			}
+		}
+
+		delete state.load( );
+	}
+
+	{
+		auto state = std::make_shared< int >( 1 );
+
+		auto timer_scope = make_benchmark_timer(
+			total_dur, iterations, "Replacing with std::atomic_store( shared_ptr )" );
+
+		for ( std::size_t i = 0; i < iterations; ++i )
+			std::atomic_store( &state, std::make_shared< int >( i ) );
+	}
+
+	{
+		std::atomic< int* > state( new int( 1 ) );
+
+		{
+			auto timer_scope = make_benchmark_timer(
+				total_dur, iterations, "Replacing with exchange and epoch retire" );
+
+			for ( std::size_t i = 0; i < iterations; ++i )
+				q::detail::epoch::retire( state.exchange(
+					new int( i ), std::memory_order_acq_rel ) );
+		}
+
+		q::detail::epoch::retire( state.exchange( nullptr ) );
+		for ( int i = 0; i < 3; ++i )
+			q::detail::epoch::flush( );
+	}
+
+	( void )sink;
+
+	std::cout << std::endl;
+}
+
 int main( int, char** )
 {
 	q::settings settings;
@@ -345,4 +417,6 @@ int main( int, char** )
 
 	benchmark_tasks_on_main_queue( iterations, false );
 	benchmark_tasks_on_threadpool( iterations, false );
+
+	benchmark_reclamation( fn_iterations );
 }
@@ -0,0 +1,104 @@
+
+#include <q/lib.hpp>
+#include <q/timer.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+/**
+ * Measures the compilation time of the translation units in samples/, using
+ * the compiler and flags of q, to see the effect of changes to the headers,
+ * such as the extern templates in q/promise/extern.hpp and q/fwd.hpp.
+ *
+ * Usage: compile-benchmark [iterations]
+ */
+
+struct variant
+{
+	std::string title;
+	std::string sample;
+	std::string flags;
+};
+
+double compile_ms( const variant& v, std::size_t iterations )
+{
+	const std::string object = "compile-benchmark-sample.o";
+	const std::string command =
+		std::string( COMPILE_BENCHMARK_COMPILER ) + " " +
+		COMPILE_BENCHMARK_FLAGS + " " + v.flags + " -c " +
+		COMPILE_BENCHMARK_SAMPLES + "/" + v.sample + " -o " + object;
+
+	std::vector< double > times;
+
+	for ( std::size_t i = 0; i < iterations; ++i )
+	{
+		auto start = q::timer::clock::now( );
+
+		if ( std::system( command.c_str( ) ) != 0 )
+		{
+			std::cerr << "Failed to compile: " << command << std::endl;
+			std::exit( 1 );
+		}
+
+		auto dur = q::timer::clock::now( ) - start;
+
+		times.push_back( static_cast< double >(
+			std::chrono::duration_cast< std::chrono::microseconds >(
+				dur ).count( ) ) / 1000.0 );
+	}
+
+	std::remove( object.c_str( ) );
+
+	std::sort( times.begin( ), times.end( ) );
+
+	return times[ times.size( ) / 2 ];
+}
+
+int main( int argc, char** argv )
+{
+	q::settings settings;
+	auto scope = q::scoped_initialize( settings );
+
+	std::size_t iterations = argc > 1 ? std::atoi( argv[ 1 ] ) : 5;
+	if ( iterations == 0 )
+		iterations = 1;
+
+	std::vector< std::pair< variant, variant > > comparisons{
+		{
+			{ "usage, implicit instantiation", "usage.cpp",
+				"-DLIBQ_NO_EXTERN_TEMPLATES" },
+			{ "usage, extern templates", "usage.cpp", "" }
+		},
+		{
+			{ "declarations, <q/promise.hpp>", "declarations.cpp", "" },
+			{ "declarations, <q/fwd.hpp>", "declarations.cpp",
+				"-DSAMPLE_USE_FWD" }
+		}
+	};
+
+	std::cout
+		<< "Median of " << iterations << " compilations" << std::endl
+		<< std::endl;
+
+	for ( auto& comparison : comparisons )
+	{
+		auto before = compile_ms( comparison.first, iterations );
+		auto after = compile_ms( comparison.second, iterations );
+
+		std::cout
+			<< std::fixed << std::setprecision( 0 )
+			<< std::setw( 32 ) << std::left << comparison.first.title
+			<< before << "ms" << std::endl
+			<< std::setw( 32 ) << std::left << comparison.second.title
+			<< after << "ms (" << std::setprecision( 1 )
+			<< ( 100.0 * ( before - after ) / before ) << "% faster)"
+			<< std::endl << std::endl;
+	}
+
+	return 0;
+}
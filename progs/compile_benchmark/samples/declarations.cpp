@@ -0,0 +1,18 @@
+// A header-like translation unit which only declares functions of promise
+// types, compiled (but never linked) by compile-benchmark.
+
+#ifdef SAMPLE_USE_FWD
+#	include <q/fwd.hpp>
+#else
+#	include <q/promise.hpp>
+#endif
+
+#include <string>
+
+q::promise< int > increment( const q::queue_ptr& queue, int i );
+
+q::promise< > ignore( q::promise< std::string > promise );
+
+q::promise< bool > non_empty( q::promise< q::byte_block > promise );
+
+q::shared_promise< > share( q::promise< > promise );
@@ -0,0 +1,44 @@
+// A typical translation unit using promises of common types, compiled (but
+// never linked) by compile-benchmark.
+
+#include <q/promise.hpp>
+
+#include <string>
+
+q::promise< int > increment( const q::queue_ptr& queue, int i )
+{
+	return q::with( queue, i )
+	.then( [ ]( int i )
+	{
+		return i + 1;
+	} );
+}
+
+q::promise< > ignore( q::promise< std::string > promise )
+{
+	return promise
+	.then( [ ]( std::string s )
+	{
+		( void )s;
+	} );
+}
+
+q::promise< bool > non_empty( q::promise< q::byte_block > promise )
+{
+	return promise
+	.then( [ ]( q::byte_block block )
+	{
+		return block.size( ) > 0;
+	} )
+	.fail( [ ]( std::exception_ptr )
+	{
+		return false;
+	} );
+}
+
+q::shared_promise< > share( q::promise< > promise )
+{
+	return promise
+	.finally( [ ]( ) { } )
+	.share( );
+}
@@ -0,0 +1,740 @@
+#include <q/promise.hpp>
+#include <q/lib.hpp>
+#include <q/blocking_dispatcher.hpp>
+#include <q/threadpool.hpp>
+#include <q/execution_context.hpp>
+#include <q/scheduler.hpp>
+#include <q/channel.hpp>
+#include <q/interval.hpp>
+#include <q/timer.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <random>
+#include <map>
+#include <thread>
+
+#ifndef LIBQ_ON_WINDOWS
+#	include <sys/resource.h>
+#endif
+
+/**
+ * A synthetic workload generator, which runs a configurable mix of typical
+ * promise and channel usage at a target rate, and reports throughput, latency
+ * percentiles, CPU utilization and peak RSS. Use it to validate scheduler and
+ * allocator changes end to end, e.g.:
+ *
+ *   loadgen --rate=20000 --duration=10 --topology=split --threads=4 \
+ *           --mix=fanout:4,chain:3,timeout:2,pipeline:1
+ *
+ * Latencies are measured from when an operation was due to start (given the
+ * rate), not from when it actually started, so that a generator falling
+ * behind shows as latency rather than being hidden (coordinated omission).
+ */
+
+namespace {
+
+typedef q::timer::clock clock_type;
+typedef q::timer::point_type point_type;
+typedef std::chrono::nanoseconds nanoseconds;
+
+struct config
+{
+	double rate = 5000;
+	double duration = 5;
+	std::size_t threads = std::max( 2u, std::thread::hardware_concurrency( ) );
+	std::string topology = "pool";
+	std::map< std::string, std::size_t > mix = {
+		{ "fanout", 4 }, { "chain", 3 }, { "timeout", 2 }, { "pipeline", 1 }
+	};
+	std::size_t fanout = 16;
+	std::size_t depth = 32;
+	std::size_t stages = 4;
+	std::size_t items = 32;
+	std::size_t work_ns = 1000;
+	std::size_t timeout_us = 2000;
+	double high_share = 0.1;
+	double low_share = 0.1;
+};
+
+const char* usage =
+	"Usage: loadgen [--option=value...]\n"
+	"\n"
+	"  --rate=N         operations per second (default 5000)\n"
+	"  --duration=S     seconds to generate load (default 5)\n"
+	"  --threads=N      worker threads (default: hardware concurrency)\n"
+	"  --topology=T     single: everything on the main thread\n"
+	"                   pool:   workers in one threadpool (default)\n"
+	"                   split:  a compute pool and a separate pool for\n"
+	"                           timers and channels\n"
+	"  --mix=K:W,...    weights of the operation kinds (default\n"
+	"                   fanout:4,chain:3,timeout:2,pipeline:1)\n"
+	"  --fanout=N       width of fanout (all) operations (default 16)\n"
+	"  --depth=N        length of then( ) chains (default 32)\n"
+	"  --stages=N       stages of channel pipelines (default 4)\n"
+	"  --items=N        items through each pipeline (default 32)\n"
+	"  --work=NS        busy work per task in ns (default 1000)\n"
+	"  --timeout=US     timeout of timeout operations (default 2000)\n"
+	"  --high=F         share of operations on the high priority queue\n"
+	"  --low=F          share of operations on the low priority queue\n";
+
+void fail( const std::string& msg )
+{
+	std::cerr << "loadgen: " << msg << std::endl << std::endl << usage;
+	std::exit( 1 );
+}
+
+config parse_args( int argc, char** argv )
+{
+	config conf;
+
+	for ( int i = 1; i < argc; ++i )
+	{
+		std::string arg = argv[ i ];
+
+		if ( arg == "--help" || arg == "-h" )
+		{
+			std::cout << usage;
+			std::exit( 0 );
+		}
+
+		auto eq = arg.find( '=' );
+		if ( arg.compare( 0, 2, "--" ) || eq == std::string::npos )
+			fail( "invalid argument: " + arg );
+
+		auto name = arg.substr( 2, eq - 2 );
+		auto value = arg.substr( eq + 1 );
+
+		auto number = [ & ]( const std::string& s ) -> double
+		{
+			try
+			{
+				return std::stod( s );
+			}
+			catch ( ... )
+			{
+				fail( "invalid number: " + arg );
+				return 0;
+			}
+		};
+
+		if ( name == "rate" )
+			conf.rate = number( value );
+		else if ( name == "duration" )
+			conf.duration = number( value );
+		else if ( name == "threads" )
+			conf.threads = number( value );
+		else if ( name == "topology" )
+			conf.topology = value;
+		else if ( name == "fanout" )
+			conf.fanout = number( value );
+		else if ( name == "depth" )
+			conf.depth = number( value );
+		else if ( name == "stages" )
+			conf.stages = number( value );
+		else if ( name == "items" )
+			conf.items = number( value );
+		else if ( name == "work" )
+			conf.work_ns = number( value );
+		else if ( name == "timeout" )
+			conf.timeout_us = number( value );
+		else if ( name == "high" )
+			conf.high_share = number( value );
+		else if ( name == "low" )
+			conf.low_share = number( value );
+		else if ( name == "mix" )
+		{
+			conf.mix.clear( );
+
+			std::istringstream ss( value );
+			std::string part;
+			while ( std::getline( ss, part, ',' ) )
+			{
+				auto colon = part.find( ':' );
+				if ( colon == std::string::npos )
+					fail( "invalid mix: " + value );
+
+				conf.mix[ part.substr( 0, colon ) ] =
+					number( part.substr( colon + 1 ) );
+			}
+		}
+		else
+			fail( "unknown option: " + name );
+	}
+
+	if (
+		conf.topology != "single" &&
+		conf.topology != "pool" &&
+		conf.topology != "split"
+	)
+		fail( "unknown topology: " + conf.topology );
+
+	for ( auto& kind : conf.mix )
+		if (
+			kind.first != "fanout" && kind.first != "chain" &&
+			kind.first != "timeout" && kind.first != "pipeline"
+		)
+			fail( "unknown operation kind: " + kind.first );
+
+	if ( conf.rate <= 0 || conf.duration <= 0 || !conf.threads )
+		fail( "rate, duration and threads must be positive" );
+
+	return conf;
+}
+
+void spin( std::size_t ns )
+{
+	auto until = clock_type::now( ) + nanoseconds( ns );
+	while ( clock_type::now( ) < until )
+		;
+}
+
+/**
+ * Collects latencies of completed operations, per kind and priority.
+ */
+class recorder
+{
+public:
+	recorder( )
+	: mutex_( Q_HERE, "loadgen recorder" )
+	, timeouts_( 0 )
+	{ }
+
+	void record( const std::string& kind, const std::string& priority,
+	             point_type due )
+	{
+		auto latency = std::chrono::duration_cast< nanoseconds >(
+			clock_type::now( ) - due ).count( );
+
+		Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+		latencies_[ kind ].push_back( latency );
+		latencies_[ "priority " + priority ].push_back( latency );
+		latencies_[ "all" ].push_back( latency );
+	}
+
+	void record_timeout( )
+	{
+		++timeouts_;
+	}
+
+	void report( std::ostream& os, double seconds )
+	{
+		Q_AUTO_UNIQUE_LOCK( mutex_ );
+
+		os
+			<< "completed:  " << latencies_[ "all" ].size( )
+			<< " (" << std::fixed << std::setprecision( 0 )
+			<< latencies_[ "all" ].size( ) / seconds << "/s)"
+			<< std::endl
+			<< "timeouts:   " << timeouts_.load( ) << std::endl
+			<< std::endl;
+
+		os
+			<< std::left << std::setw( 18 ) << "latency (us)"
+			<< std::right
+			<< std::setw( 10 ) << "count"
+			<< std::setw( 10 ) << "p50"
+			<< std::setw( 10 ) << "p90"
+			<< std::setw( 10 ) << "p99"
+			<< std::setw( 10 ) << "p99.9"
+			<< std::setw( 10 ) << "max"
+			<< std::endl;
+
+		for ( auto& entry : latencies_ )
+		{
+			auto& values = entry.second;
+
+			if ( values.empty( ) )
+				continue;
+
+			std::sort( values.begin( ), values.end( ) );
+
+			auto percentile = [ &values ]( double p )
+			{
+				auto index = static_cast< std::size_t >(
+					p * ( values.size( ) - 1 ) );
+				return values[ index ] / 1000.0;
+			};
+
+			os
+				<< std::left << std::setw( 18 ) << entry.first
+				<< std::right << std::setprecision( 1 )
+				<< std::setw( 10 ) << values.size( )
+				<< std::setw( 10 ) << percentile( 0.5 )
+				<< std::setw( 10 ) << percentile( 0.9 )
+				<< std::setw( 10 ) << percentile( 0.99 )
+				<< std::setw( 10 ) << percentile( 0.999 )
+				<< std::setw( 10 ) << percentile( 1 )
+				<< std::endl;
+		}
+	}
+
+private:
+	q::mutex mutex_;
+	std::map< std::string, std::vector< std::int64_t > > latencies_;
+	std::atomic< std::size_t > timeouts_;
+};
+
+/**
+ * The dispatchers and queues of a topology. Operations run their work on one
+ * of the worker queues (by priority), and their timers and channels on
+ * io_queue.
+ */
+struct topology
+{
+	q::queue_ptr main_queue;
+	std::shared_ptr< q::blocking_dispatcher > main;
+	std::vector< std::shared_ptr< q::threadpool > > pools;
+
+	q::queue_ptr high_queue;
+	q::queue_ptr normal_queue;
+	q::queue_ptr low_queue;
+	q::queue_ptr io_queue;
+
+	static topology make( const config& conf )
+	{
+		topology t;
+
+		std::tie( t.main, t.main_queue ) =
+			q::make_event_dispatcher_and_queue<
+				q::blocking_dispatcher, q::direct_scheduler
+			>( "loadgen main" );
+
+		if ( conf.topology == "single" )
+		{
+			t.high_queue = t.normal_queue = t.low_queue =
+				t.io_queue = t.main_queue;
+			return t;
+		}
+
+		auto threads = conf.threads;
+		if ( conf.topology == "split" && threads > 1 )
+			--threads;
+
+		auto workers = q::make_execution_context<
+			q::threadpool, q::priority_scheduler
+		>( "loadgen workers", t.main_queue, threads );
+
+		t.pools.push_back( workers->dispatcher( ) );
+
+		// The priority_scheduler serves lower priority values first
+		t.normal_queue = workers->queue( );
+		t.high_queue = q::queue::construct(
+			t.normal_queue->priority( ) - 1 );
+		t.low_queue = q::queue::construct(
+			t.normal_queue->priority( ) + 1 );
+
+		workers->scheduler( )->add_queue( t.high_queue );
+		workers->scheduler( )->add_queue( t.low_queue );
+
+		if ( conf.topology == "split" )
+		{
+			auto io = q::make_execution_context<
+				q::threadpool, q::direct_scheduler
+			>( "loadgen io", t.main_queue, 1 );
+
+			t.pools.push_back( io->dispatcher( ) );
+			t.io_queue = io->queue( );
+		}
+		else
+			t.io_queue = t.normal_queue;
+
+		return t;
+	}
+};
+
+struct operation
+{
+	std::string kind;
+	std::string priority;
+	q::queue_ptr queue;
+	point_type due;
+};
+
+class generator
+{
+public:
+	generator( const config& conf, topology& topo )
+	: conf_( conf )
+	, topo_( topo )
+	, rng_( 4711 )
+	, outstanding_( 0 )
+	, launched_( 0 )
+	{
+		for ( auto& kind : conf.mix )
+			if ( kind.second )
+			{
+				kinds_.push_back( kind.first );
+				weights_.push_back( kind.second );
+			}
+
+		if ( kinds_.empty( ) )
+			fail( "the mix is empty" );
+	}
+
+	/**
+	 * Launches operations at the target rate until the duration has
+	 * passed, and resolves when all of them have completed.
+	 */
+	q::promise< > run( )
+	{
+		start_ = clock_type::now( );
+
+		auto ticks = q::interval(
+			topo_.main_queue, std::chrono::milliseconds( 1 ) );
+
+		auto total = static_cast< std::size_t >(
+			conf_.rate * conf_.duration );
+
+		return ticks.consume( [ this, ticks, total ]( point_type ) mutable
+		{
+			auto elapsed = std::chrono::duration< double >(
+				clock_type::now( ) - start_ ).count( );
+
+			auto due = std::min( total, static_cast< std::size_t >(
+				elapsed * conf_.rate ) );
+
+			while ( launched_ < due )
+				launch( launched_++ );
+
+			if ( launched_ >= total )
+				ticks.close( );
+		} )
+		.then( [ this ]( )
+		{
+			return drain( );
+		} );
+	}
+
+	recorder& results( )
+	{
+		return recorder_;
+	}
+
+private:
+	void launch( std::size_t index )
+	{
+		std::discrete_distribution< std::size_t > kind_dist(
+			weights_.begin( ), weights_.end( ) );
+		std::uniform_real_distribution< double > share( 0, 1 );
+
+		operation op;
+		op.kind = kinds_[ kind_dist( rng_ ) ];
+		op.due = start_ + std::chrono::duration_cast< nanoseconds >(
+			std::chrono::duration< double >( index / conf_.rate ) );
+
+		auto p = share( rng_ );
+		if ( p < conf_.high_share )
+		{
+			op.priority = "high";
+			op.queue = topo_.high_queue;
+		}
+		else if ( p < conf_.high_share + conf_.low_share )
+		{
+			op.priority = "low";
+			op.queue = topo_.low_queue;
+		}
+		else
+		{
+			op.priority = "normal";
+			op.queue = topo_.normal_queue;
+		}
+
+		++outstanding_;
+
+		run_operation( op )
+		.fail( [ ]( std::exception_ptr e )
+		{
+			std::cerr << "operation failed: "
+				<< q::stream_exception( e ) << std::endl;
+		} )
+		.finally( [ this, op ]( )
+		{
+			recorder_.record( op.kind, op.priority, op.due );
+			--outstanding_;
+		} );
+	}
+
+	q::promise< > run_operation( const operation& op )
+	{
+		if ( op.kind == "fanout" )
+			return fanout( op );
+		else if ( op.kind == "chain" )
+			return chain( op );
+		else if ( op.kind == "timeout" )
+			return timeout( op );
+		else
+			return pipeline( op );
+	}
+
+	/**
+	 * Fans out to a number of parallel tasks, and joins them with all( ).
+	 */
+	q::promise< > fanout( const operation& op )
+	{
+		auto work = conf_.work_ns;
+
+		std::vector< q::promise< > > tasks;
+		for ( std::size_t i = 0; i < conf_.fanout; ++i )
+			tasks.push_back( q::async( op.queue, [ work ]( )
+			{
+				spin( work );
+			} ) );
+
+		return q::all( std::move( tasks ), op.queue );
+	}
+
+	/**
+	 * A deep chain of then( ) continuations, each doing a little work.
+	 */
+	q::promise< > chain( const operation& op )
+	{
+		auto work = conf_.work_ns;
+
+		auto promise = q::with( op.queue, std::size_t( 0 ) );
+
+		for ( std::size_t i = 0; i < conf_.depth; ++i )
+			promise = promise.then( [ work ]( std::size_t n )
+			{
+				spin( work / 4 );
+				return n + 1;
+			} );
+
+		return promise.then( [ ]( std::size_t ) { } );
+	}
+
+	/**
+	 * Work racing a timer, as for a request with a timeout. The work takes
+	 * up to twice the timeout, so roughly half of the timers fire first.
+	 * Timers which lose the race still fire later, like typical timeouts
+	 * which aren't cancelled.
+	 */
+	q::promise< > timeout( const operation& op )
+	{
+		std::uniform_int_distribution< std::size_t > dist(
+			0, 2 * conf_.timeout_us );
+		auto work_time = std::chrono::microseconds( dist( rng_ ) );
+		auto timeout = std::chrono::microseconds( conf_.timeout_us );
+
+		auto self = this;
+		auto queue = op.queue;
+		auto io_queue = topo_.io_queue;
+
+		return q::make_promise( queue,
+			[ self, queue, io_queue, work_time, timeout ](
+				q::resolver< > resolve, q::rejecter< >
+			)
+		{
+			auto done = std::make_shared< std::atomic< bool > >(
+				false );
+
+			q::delay( queue, work_time )
+			.then( [ done, resolve ]( ) mutable
+			{
+				if ( !done->exchange( true ) )
+					resolve( );
+			} );
+
+			q::delay( io_queue, timeout )
+			.then( [ self, done, resolve ]( ) mutable
+			{
+				if ( !done->exchange( true ) )
+				{
+					self->recorder_.record_timeout( );
+					resolve( );
+				}
+			} );
+		} );
+	}
+
+	/**
+	 * A multi-stage channel pipeline, with a little work per item and
+	 * stage, fed by a producer respecting backpressure.
+	 */
+	q::promise< > pipeline( const operation& op )
+	{
+		auto work = conf_.work_ns;
+		auto items = conf_.items;
+
+		q::channel< std::size_t > source( topo_.io_queue, 8 );
+		auto readable = source.get_readable( );
+
+		for ( std::size_t stage = 0; stage < conf_.stages; ++stage )
+		{
+			q::channel< std::size_t > next( topo_.io_queue, 8 );
+			auto writable = next.get_writable( );
+			auto queue = op.queue;
+
+			readable.consume( [ writable, queue, work ](
+				std::size_t item
+			) mutable
+			{
+				return q::async( queue, [ work, item ]( )
+				{
+					spin( work );
+					return item + 1;
+				} )
+				.then( [ writable ]( std::size_t item ) mutable
+				{
+					return writable.write_async( item );
+				} )
+				.then( [ ]( bool ) { } );
+			} )
+			.finally( [ writable ]( ) mutable
+			{
+				writable.close( );
+			} );
+
+			readable = next.get_readable( );
+		}
+
+		auto writable = source.get_writable( );
+		auto produce = std::make_shared< q::function< void( ) > >( );
+		std::weak_ptr< q::function< void( ) > > weak_produce = produce;
+		auto written = std::make_shared< std::size_t >( 0 );
+
+		*produce = [ writable, weak_produce, written, items ]( ) mutable
+		{
+			auto produce = weak_produce.lock( );
+
+			if ( *written == items )
+			{
+				writable.close( );
+				return;
+			}
+
+			writable.write_async( ( *written )++ )
+			.then( [ produce ]( bool accepted )
+			{
+				if ( accepted )
+					( *produce )( );
+			} );
+		};
+		( *produce )( );
+
+		return readable.consume( [ ]( std::size_t ) { } );
+	}
+
+	q::promise< > drain( )
+	{
+		if ( !outstanding_ )
+			return q::with( topo_.main_queue );
+
+		return q::delay( topo_.main_queue, std::chrono::milliseconds( 10 ) )
+		.then( [ this ]( )
+		{
+			return drain( );
+		} );
+	}
+
+	const config& conf_;
+	topology& topo_;
+	std::mt19937 rng_;
+	std::vector< std::string > kinds_;
+	std::vector< std::size_t > weights_;
+	point_type start_;
+	std::atomic< std::size_t > outstanding_;
+	std::size_t launched_;
+	recorder recorder_;
+};
+
+struct usage_snapshot
+{
+	double cpu_seconds = 0;
+	long peak_rss_kb = 0;
+
+	static usage_snapshot take( )
+	{
+		usage_snapshot snapshot;
+
+#ifndef LIBQ_ON_WINDOWS
+		struct rusage usage;
+		if ( !getrusage( RUSAGE_SELF, &usage ) )
+		{
+			auto seconds = [ ]( const struct timeval& tv )
+			{
+				return tv.tv_sec + tv.tv_usec / 1e6;
+			};
+
+			snapshot.cpu_seconds =
+				seconds( usage.ru_utime ) + seconds( usage.ru_stime );
+			snapshot.peak_rss_kb = usage.ru_maxrss;
+		}
+#endif
+
+		return snapshot;
+	}
+};
+
+} // anonymous namespace
+
+int main( int argc, char** argv )
+{
+	auto conf = parse_args( argc, argv );
+
+	auto scope = q::scoped_initialize( );
+
+	auto topo = topology::make( conf );
+
+	generator gen( conf, topo );
+
+	std::cout
+		<< "topology " << conf.topology
+		<< ", " << conf.threads << " threads"
+		<< ", " << conf.rate << " ops/s for " << conf.duration << "s"
+		<< std::endl << std::endl;
+
+	auto usage_before = usage_snapshot::take( );
+	auto start = clock_type::now( );
+
+	gen.run( )
+	.fail( [ ]( std::exception_ptr e )
+	{
+		std::cerr << "load generation failed: "
+			<< q::stream_exception( e ) << std::endl;
+	} )
+	.finally( [ &topo ]( )
+	{
+		// The main queue is included, as the topology may have no pools
+		std::vector< q::promise< > > terminations;
+		terminations.push_back( q::with( topo.main_queue ) );
+		for ( auto& pool : topo.pools )
+			terminations.push_back(
+				pool->terminate( q::termination::linger ) );
+
+		q::all( std::move( terminations ), topo.main_queue )
+		.finally( [ &topo ]( )
+		{
+			for ( auto& pool : topo.pools )
+				pool->await_termination( );
+
+			topo.main->terminate( q::termination::linger );
+		} );
+	} );
+
+	topo.main->start( );
+	topo.main->await_termination( );
+
+	auto seconds = std::chrono::duration< double >(
+		clock_type::now( ) - start ).count( );
+	auto usage_after = usage_snapshot::take( );
+
+	gen.results( ).report( std::cout, seconds );
+
+	auto cpu = usage_after.cpu_seconds - usage_before.cpu_seconds;
+	auto cores = std::max( 1u, std::thread::hardware_concurrency( ) );
+
+	std::cout
+		<< std::endl
+		<< std::setprecision( 2 )
+		<< "wall time:  " << seconds << "s" << std::endl
+		<< "cpu time:   " << cpu << "s ("
+		<< ( 100 * cpu / seconds ) << "% of one core, "
+		<< ( 100 * cpu / seconds / cores ) << "% of " << cores
+		<< " cores)" << std::endl
+		<< "peak rss:   " << usage_after.peak_rss_kb / 1024.0 << " MiB"
+		<< std::endl;
+}
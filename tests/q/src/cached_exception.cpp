@@ -0,0 +1,95 @@
+#include <q/channel.hpp>
+#include <q/exception.hpp>
+
+#include "core.hpp"
+
+Q_TEST_MAKE_SCOPE( cached_exception );
+
+namespace {
+
+Q_MAKE_SIMPLE_EXCEPTION( simple_exception );
+
+class valued_exception
+: public q::exception
+{
+public:
+	valued_exception( int value )
+	: value_( value )
+	{ }
+
+	int value( ) const
+	{
+		return value_;
+	}
+
+private:
+	int value_;
+};
+
+} // anonymous namespace
+
+TEST_F( cached_exception, is_created_once )
+{
+	auto& first = q::cached_exception< simple_exception >( );
+	auto& second = q::cached_exception< simple_exception >( );
+
+	EXPECT_EQ( &first, &second );
+	EXPECT_EQ( first, second );
+	EXPECT_THROW( std::rethrow_exception( first ), simple_exception );
+
+	EXPECT_FALSE( q::register_cached_exception( simple_exception( ) ) );
+	EXPECT_EQ( &first, &q::cached_exception< simple_exception >( ) );
+}
+
+TEST_F( cached_exception, registers_custom_exceptions )
+{
+	EXPECT_TRUE( q::register_cached_exception( valued_exception( 17 ) ) );
+	EXPECT_FALSE( q::register_cached_exception( valued_exception( 4 ) ) );
+
+	try
+	{
+		std::rethrow_exception(
+			q::cached_exception< valued_exception >( ) );
+	}
+	catch ( const valued_exception& e )
+	{
+		EXPECT_EQ( 17, e.value( ) );
+	}
+}
+
+TEST_F( cached_exception, closed_channel_rejections_are_cached )
+{
+	q::channel< int > ch( queue, 5 );
+
+	auto readable = ch.get_readable( );
+	auto writable = ch.get_writable( );
+
+	writable.close( );
+
+	auto errors = std::make_shared< std::vector< std::exception_ptr > >( );
+
+	auto store = [ errors ]( std::exception_ptr e )
+	{
+		errors->push_back( e );
+	};
+
+	run(
+		readable.read( )
+		.then( [ ]( int ) { } )
+		.fail( store )
+		.then( [ readable ]( ) mutable
+		{
+			return readable.read( );
+		} )
+		.then( [ ]( int ) { } )
+		.fail( store )
+		.then( [ errors ]( )
+		{
+			ASSERT_EQ( 2u, errors->size( ) );
+			EXPECT_EQ( ( *errors )[ 0 ], ( *errors )[ 1 ] );
+			EXPECT_EQ(
+				q::cached_exception< q::channel_closed_exception >( ),
+				( *errors )[ 0 ] );
+		} )
+	);
+}
@@ -1267,3 +1267,184 @@ TEST_F( channel, writable_destruction_should_close )
 		readable.read( ), q::channel_closed_exception );
 	EXPECT_TRUE( readable.is_closed( ) );
 }
+
+TEST_F( channel, try_read )
+{
+	q::channel< int > ch( queue, 5 );
+
+	auto readable = ch.get_readable( );
+	auto writable = ch.get_writable( );
+
+	auto result = readable.try_read( );
+	EXPECT_EQ( q::read_status::empty, result.status );
+	EXPECT_FALSE( result.value );
+
+	EXPECT_TRUE( writable.write( 17 ) );
+	EXPECT_TRUE( writable.write( 47 ) );
+	writable.close( );
+
+	result = readable.try_read( );
+	ASSERT_EQ( q::read_status::value, result.status );
+	EXPECT_EQ( 17, std::get< 0 >( *result.value ) );
+
+	result = readable.try_read( );
+	ASSERT_EQ( q::read_status::value, result.status );
+	EXPECT_EQ( 47, std::get< 0 >( *result.value ) );
+
+	result = readable.try_read( );
+	EXPECT_EQ( q::read_status::closed, result.status );
+	EXPECT_FALSE( result.value );
+}
+
+TEST_F( channel, read_optional )
+{
+	q::channel< int > ch( queue, 5 );
+
+	auto readable = ch.get_readable( );
+	auto writable = ch.get_writable( );
+
+	EXPECT_TRUE( writable.write( 17 ) );
+
+	typedef q::optional< std::tuple< int > > optional_type;
+
+	run(
+		readable.read_optional( )
+		.then( [ readable, writable ]( optional_type&& value ) mutable
+		{
+			EXPECT_TRUE( value );
+			EXPECT_EQ( 17, std::get< 0 >( *value ) );
+
+			// Pending when the channel gets closed
+			auto next = readable.read_optional( );
+			writable.close( );
+			return next;
+		} )
+		.then( [ readable ]( optional_type&& value ) mutable
+		{
+			EXPECT_FALSE( value );
+
+			return readable.read_optional( );
+		} )
+		.then( [ ]( optional_type&& value )
+		{
+			EXPECT_FALSE( value );
+		} )
+	);
+}
+
+TEST_F( channel, read_optional_rejects_on_error )
+{
+	q::channel< int > ch( queue, 5 );
+
+	auto readable = ch.get_readable( );
+	auto writable = ch.get_writable( );
+
+	writable.close( test_exception( ) );
+
+	EVENTUALLY_EXPECT_REJECTION_WITH(
+		readable.read_optional( ), test_exception );
+}
+
+TEST_F( channel, consume_closes_on_error )
+{
+	q::channel< int > ch( queue, 5 );
+
+	auto readable = ch.get_readable( );
+	auto writable = ch.get_writable( );
+
+	EXPECT_TRUE( writable.write( 17 ) );
+	EXPECT_TRUE( writable.write( 47 ) );
+
+	auto on_value = [ ]( int value )
+	{
+		if ( value == 47 )
+			Q_THROW( test_exception( ) );
+	};
+
+	run(
+		readable.consume( EXPECT_N_CALLS_WRAPPER( 2, on_value ) )
+		.then( EXPECT_NO_CALL_WRAPPER( [ ]( ) { } ) )
+		.fail( EXPECT_CALL_WRAPPER( [ ]( const test_exception& ) { } ) )
+	);
+
+	EXPECT_TRUE( writable.is_closed( ) );
+	EXPECT_FALSE( writable.write( 4711 ) );
+}
+
+TEST_F( channel, write_async_admits_writers_in_order )
+{
+	q::channel< int > ch( queue, 2 );
+
+	auto readable = ch.get_readable( );
+	auto writable = ch.get_writable( );
+
+	auto accepted = std::make_shared< std::vector< int > >( );
+
+	std::vector< q::promise< > > writes;
+	for ( int i = 0; i < 5; ++i )
+		writes.push_back( writable.write_async( i )
+			.then( [ accepted, i ]( bool success )
+			{
+				EXPECT_TRUE( success );
+				accepted->push_back( i );
+			} ) );
+
+	auto read = [ readable ]( int expected ) mutable
+	{
+		auto result = readable.try_read( );
+		ASSERT_EQ( q::read_status::value, result.status );
+		EXPECT_EQ( expected, std::get< 0 >( *result.value ) );
+	};
+
+	run(
+		q::with( queue )
+		.then( [ accepted, read ]( ) mutable
+		{
+			EXPECT_EQ( ( std::vector< int >{ 0, 1 } ), *accepted );
+			read( 0 );
+		} )
+		.then( [ accepted, read ]( ) mutable
+		{
+			EXPECT_EQ( ( std::vector< int >{ 0, 1, 2 } ), *accepted );
+			read( 1 );
+			read( 2 );
+		} )
+		.then( [ accepted, read ]( ) mutable
+		{
+			EXPECT_EQ( ( std::vector< int >{ 0, 1, 2, 3, 4 } ),
+				*accepted );
+			read( 3 );
+			read( 4 );
+		} )
+	);
+
+	run( q::all( std::move( writes ), queue ) );
+}
+
+TEST_F( channel, write_async_resolves_false_when_closed )
+{
+	q::channel< int > ch( queue, 1 );
+
+	auto readable = ch.get_readable( );
+	auto writable = ch.get_writable( );
+
+	auto first = writable.write_async( 17 );
+	auto second = writable.write_async( 47 );
+
+	writable.close( );
+
+	run(
+		q::all( std::move( first ), std::move( second ) )
+		.then( [ writable ]( bool first, bool second ) mutable
+		{
+			EXPECT_TRUE( first );
+			EXPECT_FALSE( second );
+
+			return writable.write_async( 4711 );
+		} )
+		.then( [ ]( bool success )
+		{
+			EXPECT_FALSE( success );
+		} )
+	);
+}
@@ -0,0 +1,56 @@
+
+#include "core.hpp"
+
+#include <q/clock.hpp>
+
+#include <thread>
+
+Q_TEST_MAKE_SCOPE( clocks );
+
+TEST_F( clocks, timer_clock_is_steady )
+{
+	EXPECT_TRUE( q::timer::clock::is_steady );
+}
+
+TEST_F( clocks, coarse_clock_lags_within_resolution )
+{
+	auto resolution = q::coarse_clock::resolution( );
+
+	auto before = q::steady_clock::now( );
+	auto coarse = q::coarse_clock::now( );
+	auto after = q::steady_clock::now( );
+
+	EXPECT_LE( coarse, after );
+	EXPECT_GE( coarse + resolution * 2, before );
+}
+
+TEST_F( clocks, tsc_clock_measures_durations )
+{
+	auto before = q::tsc_clock::now( );
+	auto steady_before = q::steady_clock::now( );
+
+	std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+
+	auto after = q::tsc_clock::now( );
+	auto steady_after = q::steady_clock::now( );
+
+	auto tsc_ms = std::chrono::duration_cast< std::chrono::milliseconds >(
+		after - before ).count( );
+	auto steady_ms = std::chrono::duration_cast< std::chrono::milliseconds >(
+		steady_after - steady_before ).count( );
+
+	EXPECT_GE( tsc_ms, steady_ms * 3 / 4 );
+	EXPECT_LE( tsc_ms, steady_ms * 5 / 4 + 1 );
+}
+
+TEST_F( clocks, now_within_picks_accurate_clock )
+{
+	auto before = q::steady_clock::now( );
+
+	auto precise = q::now_within( q::steady_clock::duration::zero( ) );
+	EXPECT_GE( precise, before );
+
+	auto accuracy = std::chrono::milliseconds( 100 );
+	auto cheap = q::now_within( accuracy );
+	EXPECT_GE( cheap + accuracy, before );
+}
@@ -0,0 +1,85 @@
+#include "core.hpp"
+
+#include <q/context.hpp>
+
+#include <string>
+
+Q_TEST_MAKE_SCOPE( context );
+
+namespace {
+
+q::context_slot< std::string > request_id;
+q::context_slot< int > tenant;
+
+} // anonymous namespace
+
+TEST_F( context, scopes_set_and_restore_values )
+{
+	EXPECT_FALSE( q::context::current( ) );
+	EXPECT_EQ( nullptr, request_id.get( ) );
+
+	{
+		q::context_scope outer( request_id, std::string( "outer" ) );
+
+		EXPECT_EQ( "outer", *request_id.get( ) );
+		EXPECT_EQ( 7, tenant.get_or( 7 ) );
+
+		{
+			q::context_scope inner( request_id, std::string( "inner" ) );
+			q::context_scope tenant_scope( tenant, 3 );
+
+			EXPECT_EQ( "inner", *request_id.get( ) );
+			EXPECT_EQ( 3, tenant.get_or( 7 ) );
+		}
+
+		EXPECT_EQ( "outer", *request_id.get( ) );
+		EXPECT_EQ( nullptr, tenant.get( ) );
+	}
+
+	EXPECT_FALSE( q::context::current( ) );
+}
+
+TEST_F( context, follows_continuations_across_queues )
+{
+	auto tp_queue = this->tp_queue;
+
+	auto promise = ( [ this, tp_queue ]( )
+	{
+		q::context_scope scope( request_id, std::string( "abc" ) );
+
+		return q::with( tp_queue )
+		.then( [ tp_queue ]( )
+		{
+			EXPECT_EQ( "abc", request_id.get_or( "" ) );
+
+			q::context_scope scope( tenant, 5 );
+
+			return q::async( tp_queue, [ ]( )
+			{
+				return tenant.get_or( 0 );
+			} );
+		} )
+		.then( [ ]( int tenant_value )
+		{
+			// The tenant was only set within the previous continuation
+			EXPECT_EQ( 5, tenant_value );
+			EXPECT_EQ( nullptr, tenant.get( ) );
+			EXPECT_EQ( "abc", request_id.get_or( "" ) );
+		}, queue );
+	} )( );
+
+	EXPECT_FALSE( q::context::current( ) );
+
+	run( std::move( promise ) );
+}
+
+TEST_F( context, is_not_set_without_scope )
+{
+	run(
+		q::with( tp_queue )
+		.then( [ ]( )
+		{
+			EXPECT_FALSE( q::context::current( ) );
+		} )
+	);
+}
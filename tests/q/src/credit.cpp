@@ -0,0 +1,110 @@
+#include "core.hpp"
+
+#include <q/credit.hpp>
+
+Q_TEST_MAKE_SCOPE( credit_pool );
+
+TEST_F( credit_pool, credits_are_granted_in_order )
+{
+	auto pool = q::credit_pool::construct( 1 );
+
+	auto first = std::make_shared< q::credit >( pool->try_acquire( ) );
+
+	EXPECT_TRUE( !!*first );
+	EXPECT_FALSE( !!pool->try_acquire( ) );
+	EXPECT_EQ( 1u, pool->in_flight( ) );
+
+	auto order = std::make_shared< std::vector< int > >( );
+
+	auto second = pool->acquire( queue )
+	.then( [ order ]( q::credit )
+	{
+		order->push_back( 2 );
+	} );
+
+	auto third = pool->acquire( queue )
+	.then( [ order ]( q::credit )
+	{
+		order->push_back( 3 );
+	} );
+
+	EXPECT_EQ( 2u, pool->waiting( ) );
+
+	first->release( );
+
+	run(
+		q::all( std::move( second ), std::move( third ) )
+		.then( [ order, pool ]( )
+		{
+			EXPECT_EQ( ( std::vector< int >{ 2, 3 } ), *order );
+			EXPECT_EQ( 0u, pool->in_flight( ) );
+			EXPECT_EQ( 0u, pool->waiting( ) );
+		} )
+	);
+}
+
+TEST_F( credit_pool, raising_credits_grants_waiters )
+{
+	auto pool = q::credit_pool::construct( 0 );
+
+	EXPECT_FALSE( !!pool->try_acquire( ) );
+
+	auto acquired = pool->acquire( queue )
+	.then( [ pool ]( q::credit c )
+	{
+		EXPECT_TRUE( !!c );
+		EXPECT_EQ( 1u, pool->in_flight( ) );
+	} );
+
+	pool->set_credits( 1 );
+
+	run( std::move( acquired ) );
+
+	EXPECT_EQ( 0u, pool->in_flight( ) );
+}
+
+TEST_F( credit_pool, bounds_a_pipeline )
+{
+	auto pool = q::credit_pool::construct( 3 );
+
+	q::channel< int > source( queue, 100 );
+	q::channel< q::credit, int > first( queue, 100 );
+	q::channel< q::credit, int > second( queue, 100 );
+
+	auto writable = source.get_writable( );
+	for ( int i = 0; i < 20; ++i )
+		EXPECT_TRUE( writable.write( i ) );
+	writable.close( );
+
+	auto fed = pool->feed( source.get_readable( ), first.get_writable( ) );
+
+	first.get_readable( ).pipe( second.get_writable( ) );
+
+	auto received = std::make_shared< std::vector< int > >( );
+	auto max_in_flight = std::make_shared< std::size_t >( 0 );
+
+	auto consumer = [ pool, received, max_in_flight ](
+		q::credit c, int value
+	)
+	{
+		EXPECT_TRUE( !!c );
+		*max_in_flight = std::max( *max_in_flight, pool->in_flight( ) );
+		received->push_back( value );
+	};
+
+	run(
+		second.get_readable( ).consume( consumer )
+		.then( [ received, max_in_flight, pool ]( )
+		{
+			ASSERT_EQ( 20u, received->size( ) );
+			for ( int i = 0; i < 20; ++i )
+				EXPECT_EQ( i, ( *received )[ i ] );
+
+			EXPECT_GE( 3u, *max_in_flight );
+			EXPECT_LE( 1u, *max_in_flight );
+			EXPECT_EQ( 0u, pool->in_flight( ) );
+		} )
+	);
+
+	run( std::move( fed ) );
+}
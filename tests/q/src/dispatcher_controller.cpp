@@ -0,0 +1,122 @@
+
+#include "core.hpp"
+
+#include <q/dispatcher_controller.hpp>
+
+#include <atomic>
+
+Q_TEST_MAKE_SCOPE( dispatcher_controller );
+
+TEST_F( dispatcher_controller, threadpool_tunables_are_clamped )
+{
+	auto tunables = tp->tunables( );
+
+	EXPECT_EQ( 2u, tunables.active_threads );
+	EXPECT_EQ( 1u, tunables.batch_size );
+	EXPECT_EQ( 0, tunables.spin.count( ) );
+
+	tunables.active_threads = 5;
+	tunables.batch_size = 0;
+	tp->set_tunables( tunables );
+
+	tunables = tp->tunables( );
+
+	EXPECT_EQ( 2u, tunables.active_threads );
+	EXPECT_EQ( 1u, tunables.batch_size );
+}
+
+TEST_F( dispatcher_controller, threadpool_runs_all_tasks_when_tuned )
+{
+	q::dispatcher_tunables tunables;
+	tunables.active_threads = 1;
+	tunables.batch_size = 4;
+	tunables.spin = std::chrono::microseconds( 20 );
+	tp->set_tunables( tunables );
+
+	auto counter = std::make_shared< std::atomic< std::size_t > >( 0 );
+	auto tp = this->tp;
+
+	std::vector< q::promise< > > promises;
+	for ( std::size_t i = 0; i < 100; ++i )
+		promises.push_back( q::async( tp_queue, [ counter ]( )
+		{
+			++*counter;
+		} ) );
+
+	run(
+		q::all( std::move( promises ), queue )
+		.then( [ counter, tp ]( )
+		{
+			EXPECT_EQ( 100u, counter->load( ) );
+			EXPECT_GE( tp->statistics( ).tasks, 100u );
+		} )
+	);
+}
+
+TEST_F( dispatcher_controller, sample_adjusts_within_bounds )
+{
+	q::dispatcher_controller::bounds bounds;
+	bounds.max_batch_size = 8;
+	bounds.target_wait = q::timer::duration_type::zero( );
+
+	auto decisions = std::make_shared< std::atomic< std::size_t > >( 0 );
+
+	auto controller = q::dispatcher_controller::construct(
+		tp, tp_queue, queue, bounds,
+		[ decisions ]( const q::dispatcher_controller::decision& )
+		{
+			++*decisions;
+		} );
+
+	// Nothing has run and no probe has been sent, so the pool is idle
+	auto first = controller->sample( );
+
+	EXPECT_EQ( 2u, first.previous.active_threads );
+	EXPECT_EQ( 1u, first.tunables.active_threads );
+	EXPECT_EQ( 1u, first.tunables.batch_size );
+	EXPECT_EQ( 1u, tp->tunables( ).active_threads );
+	EXPECT_EQ( 1u, decisions->load( ) );
+
+	// The probe was queued before this task, on the single active thread,
+	// so its wait time has been measured once this task has run.
+	run(
+		q::async( tp_queue, [ ]( ) { } )
+		.then( [ controller, decisions ]( )
+		{
+			auto second = controller->sample( );
+
+			EXPECT_GT( second.wait.count( ), 0 );
+			EXPECT_EQ( 2u, second.tunables.active_threads );
+			EXPECT_EQ( 2u, second.tunables.batch_size );
+			EXPECT_EQ( 2u, decisions->load( ) );
+		}, queue )
+	);
+}
+
+TEST_F( dispatcher_controller, samples_periodically_when_started )
+{
+	q::dispatcher_controller::bounds bounds;
+	bounds.interval = std::chrono::milliseconds( 1 );
+
+	auto decisions = std::make_shared< std::atomic< std::size_t > >( 0 );
+
+	auto controller = q::dispatcher_controller::construct(
+		tp, tp_queue, queue, bounds,
+		[ decisions ]( const q::dispatcher_controller::decision& )
+		{
+			++*decisions;
+		} );
+
+	controller->start( );
+
+	run(
+		q::with( queue )
+		.delay( std::chrono::milliseconds( 20 ) )
+		.then( [ controller, decisions ]( )
+		{
+			controller->stop( );
+
+			EXPECT_GT( decisions->load( ), 0u );
+		} )
+	);
+}
@@ -0,0 +1,145 @@
+
+#include "core.hpp"
+
+#include <detail/epoch.hpp>
+
+#include <thread>
+
+Q_TEST_MAKE_SCOPE( epoch );
+
+namespace {
+
+struct tracked
+{
+	tracked( std::atomic< int >& deleted )
+	: deleted_( deleted )
+	{ }
+
+	~tracked( )
+	{
+		++deleted_;
+	}
+
+	std::atomic< int >& deleted_;
+};
+
+void flush_until_empty( )
+{
+	for ( int i = 0; i < 10 && q::detail::epoch::pending( ) > 0; ++i )
+		q::detail::epoch::flush( );
+}
+
+} // anonymous namespace
+
+TEST_F( epoch, retired_pointer_outlives_pinned_readers )
+{
+	namespace epoch = q::detail::epoch;
+
+	std::atomic< int > deleted( 0 );
+	std::atomic< int > phase( 0 );
+
+	std::thread reader( [ &phase ]( )
+	{
+		epoch::guard guard;
+
+		phase = 1;
+		while ( phase.load( ) != 2 )
+			std::this_thread::yield( );
+	} );
+
+	while ( phase.load( ) != 1 )
+		std::this_thread::yield( );
+
+	epoch::retire( new tracked( deleted ) );
+
+	for ( int i = 0; i < 10; ++i )
+		epoch::flush( );
+
+	EXPECT_EQ( 0, deleted.load( ) );
+	EXPECT_EQ( 1u, epoch::pending( ) );
+
+	phase = 2;
+	reader.join( );
+
+	flush_until_empty( );
+
+	EXPECT_EQ( 1, deleted.load( ) );
+	EXPECT_EQ( 0u, epoch::pending( ) );
+}
+
+TEST_F( epoch, retired_pointers_of_exited_threads_are_reclaimed )
+{
+	namespace epoch = q::detail::epoch;
+
+	std::atomic< int > deleted( 0 );
+
+	std::thread writer( [ &deleted ]( )
+	{
+		epoch::guard guard;
+
+		epoch::retire( new tracked( deleted ) );
+	} );
+	writer.join( );
+
+	for ( int i = 0; i < 10 && deleted.load( ) == 0; ++i )
+		epoch::flush( );
+
+	EXPECT_EQ( 1, deleted.load( ) );
+}
+
+TEST_F( epoch, concurrent_readers_and_writer )
+{
+	namespace epoch = q::detail::epoch;
+
+	struct node
+	{
+		node( int value )
+		: value( value )
+		, canary( 0xc0ffee )
+		{ }
+
+		~node( )
+		{
+			canary = 0;
+		}
+
+		int value;
+		std::atomic< int > canary;
+	};
+
+	std::atomic< node* > current( new node( 0 ) );
+	std::atomic< bool > done( false );
+	std::atomic< int > bad( 0 );
+
+	auto read = [ & ]( )
+	{
+		while ( !done.load( ) )
+		{
+			epoch::guard guard;
+
+			auto n = current.load( std::memory_order_acquire );
+			if ( n->canary.load( ) != 0xc0ffee )
+				++bad;
+		}
+	};
+
+	std::thread reader1( read );
+	std::thread reader2( read );
+
+	for ( int i = 1; i <= 2000; ++i )
+	{
+		auto prev = current.exchange(
+			new node( i ), std::memory_order_acq_rel );
+		epoch::retire( prev );
+	}
+
+	done = true;
+	reader1.join( );
+	reader2.join( );
+
+	epoch::retire( current.exchange( nullptr ) );
+	flush_until_empty( );
+
+	EXPECT_EQ( 0, bad.load( ) );
+	EXPECT_EQ( 0u, epoch::pending( ) );
+}
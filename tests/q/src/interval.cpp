@@ -0,0 +1,102 @@
+
+#include "core.hpp"
+
+#include <q/interval.hpp>
+
+Q_TEST_MAKE_SCOPE( interval );
+
+TEST_F( interval, ticks_are_evenly_spaced )
+{
+	auto period = std::chrono::milliseconds( 2 );
+	auto ticks = std::make_shared< std::vector< q::timer::point_type > >( );
+
+	auto readable = q::interval( queue, period );
+
+	run(
+		readable.consume( [ ticks, readable ]( q::timer::point_type tick )
+		mutable
+		{
+			ticks->push_back( tick );
+
+			if ( ticks->size( ) == 3 )
+				readable.close( );
+		} )
+		.then( [ ticks, period ]( )
+		{
+			ASSERT_EQ( 3u, ticks->size( ) );
+
+			// The scheduled tick times don't drift, although ticks
+			// may be skipped if late
+			for ( std::size_t i = 1; i < ticks->size( ); ++i )
+			{
+				auto diff = ( *ticks )[ i ] - ( *ticks )[ i - 1 ];
+
+				EXPECT_GT( diff.count( ), 0 );
+				EXPECT_EQ( 0, ( diff % period ).count( ) );
+			}
+		} )
+	);
+}
+
+TEST_F( interval, periodic_until_scope_is_destructed )
+{
+	auto counter = std::make_shared< int >( 0 );
+	auto holder = std::make_shared< std::unique_ptr< q::scope > >( );
+
+	*holder = q::make_unique< q::scope >( q::periodic(
+		queue,
+		std::chrono::milliseconds( 1 ),
+		[ counter, holder ]( )
+		{
+			if ( ++*counter == 3 )
+				// Stops the timer
+				holder->reset( );
+		}
+	) );
+
+	run(
+		q::with( queue )
+		.delay( std::chrono::milliseconds( 20 ) )
+		.then( [ counter ]( )
+		{
+			EXPECT_EQ( 3, *counter );
+		} )
+	);
+}
+
+TEST_F( interval, catch_up_fires_missed_ticks )
+{
+	auto period = std::chrono::milliseconds( 1 );
+	auto ticks = std::make_shared< std::vector< q::timer::point_type > >( );
+	auto holder = std::make_shared< std::unique_ptr< q::scope > >( );
+
+	*holder = q::make_unique< q::scope >( q::periodic(
+		queue,
+		period,
+		[ ticks, holder ]( q::timer::point_type tick )
+		{
+			ticks->push_back( tick );
+
+			if ( ticks->size( ) == 1 )
+				// Block the queue for a few periods
+				std::this_thread::sleep_for(
+					std::chrono::milliseconds( 5 ) );
+			else if ( ticks->size( ) == 4 )
+				holder->reset( );
+		},
+		q::tick_policy::catch_up
+	) );
+
+	run(
+		q::with( queue )
+		.delay( std::chrono::milliseconds( 30 ) )
+		.then( [ ticks, period ]( )
+		{
+			ASSERT_EQ( 4u, ticks->size( ) );
+
+			for ( std::size_t i = 1; i < ticks->size( ); ++i )
+				EXPECT_EQ(
+					period, ( *ticks )[ i ] - ( *ticks )[ i - 1 ] );
+		} )
+	);
+}
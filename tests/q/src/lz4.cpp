@@ -0,0 +1,179 @@
+#include "core.hpp"
+
+#include <q/lz4.hpp>
+
+#include <random>
+
+Q_TEST_MAKE_SCOPE( lz4 );
+
+namespace {
+
+std::string roundtrip( const std::string& s )
+{
+	return q::lz4::decompress( q::lz4::compress( q::byte_block( s ) ) )
+		.to_string( );
+}
+
+std::string random_string( std::size_t size, unsigned seed )
+{
+	std::mt19937 gen( seed );
+	std::uniform_int_distribution< int > dist( 0, 255 );
+
+	std::string s( size, '\0' );
+	for ( auto& c : s )
+		c = static_cast< char >( dist( gen ) );
+	return s;
+}
+
+std::string text( std::size_t size )
+{
+	static const std::string words[ ] = {
+		"channel ", "promise ", "queue ", "block ", "threadpool\n"
+	};
+
+	std::string s;
+	for ( std::size_t i = 0; s.size( ) < size; ++i )
+		s += words[ ( i * 7 + i / 3 ) % 5 ];
+	s.resize( size );
+	return s;
+}
+
+} // anonymous namespace
+
+TEST_F( lz4, roundtrips )
+{
+	EXPECT_EQ( "", roundtrip( "" ) );
+	EXPECT_EQ( "a", roundtrip( "a" ) );
+	EXPECT_EQ( "hello world!", roundtrip( "hello world!" ) );
+	EXPECT_EQ( std::string( 1000, 'x' ), roundtrip( std::string( 1000, 'x' ) ) );
+
+	auto random = random_string( 100000, 4711 );
+	EXPECT_EQ( random, roundtrip( random ) );
+
+	// Larger than the maximum match distance
+	auto long_text = text( 300000 );
+	EXPECT_EQ( long_text, roundtrip( long_text ) );
+}
+
+TEST_F( lz4, compresses_repetitive_data )
+{
+	auto long_text = text( 100000 );
+
+	auto compressed = q::lz4::compress( q::byte_block( long_text ) );
+
+	EXPECT_LT( compressed.size( ) * 10, long_text.size( ) );
+
+	auto random = random_string( 10000, 17 );
+
+	compressed = q::lz4::compress( q::byte_block( random ) );
+
+	EXPECT_GE( 4 + q::lz4::compress_bound( random.size( ) ),
+		compressed.size( ) );
+}
+
+TEST_F( lz4, decompresses_reference_block )
+{
+	// A literal 'a', a match of 10 bytes at offset 1, and 5 last literals
+	const std::uint8_t block[ ] = {
+		0x16, 'a', 0x01, 0x00,
+		0x50, 'a', 'a', 'a', 'a', 'a'
+	};
+
+	std::uint8_t out[ 32 ];
+	auto size = q::lz4::decompress( block, sizeof block, out, sizeof out );
+
+	EXPECT_EQ( std::string( 16, 'a' ),
+		std::string( reinterpret_cast< char* >( out ), size ) );
+}
+
+TEST_F( lz4, rejects_corrupt_data )
+{
+	std::uint8_t out[ 32 ];
+
+	// Offset beyond the start of the output
+	const std::uint8_t bad_offset[ ] = { 0x10, 'a', 0x02, 0x00, 0x00 };
+	EXPECT_THROW(
+		q::lz4::decompress( bad_offset, sizeof bad_offset, out, 32 ),
+		q::lz4::corrupt_data_exception );
+
+	// Literals beyond the end of the input
+	const std::uint8_t truncated[ ] = { 0x50, 'a', 'a' };
+	EXPECT_THROW(
+		q::lz4::decompress( truncated, sizeof truncated, out, 32 ),
+		q::lz4::corrupt_data_exception );
+
+	// Output larger than the capacity
+	const std::uint8_t large[ ] = { 0x1F, 'a', 0x01, 0x00, 0xFF, 0x00 };
+	EXPECT_THROW(
+		q::lz4::decompress( large, sizeof large, out, 32 ),
+		q::lz4::corrupt_data_exception );
+
+	// A size prefix which doesn't match the content
+	auto compressed = q::lz4::compress( q::byte_block( text( 1000 ) ) );
+	EXPECT_THROW(
+		q::lz4::decompress( compressed.slice( 0, compressed.size( ) - 1 ) ),
+		q::lz4::corrupt_data_exception );
+}
+
+TEST_F( lz4, compresses_chained_blocks )
+{
+	auto s = text( 20000 );
+
+	std::vector< q::byte_block > blocks{
+		q::byte_block( s.substr( 0, 7000 ) ),
+		q::byte_block( s.substr( 7000, 1 ) ),
+		q::byte_block( s.substr( 7001 ) )
+	};
+
+	auto compressed = q::lz4::compress( blocks );
+
+	EXPECT_EQ(
+		q::lz4::compress( q::byte_block( s ) ).to_string( ),
+		compressed.to_string( ) );
+	EXPECT_EQ( s, q::lz4::decompress( compressed ).to_string( ) );
+}
+
+TEST_F( lz4, compresses_channels )
+{
+	q::channel< q::byte_block > ch( queue, 3 );
+
+	auto writable = ch.get_writable( );
+
+	auto compressed = q::lz4::compress( ch.get_readable( ), tp_queue );
+	auto decompressed = q::lz4::decompress( compressed, tp_queue );
+
+	std::vector< std::string > expected;
+	for ( std::size_t i = 0; i < 20; ++i )
+		expected.push_back( text( 1000 + i * 500 ) );
+
+	for ( auto& s : expected )
+		q::ignore_result( writable.write( q::byte_block( s ) ) );
+	writable.close( );
+
+	auto received = std::make_shared< std::vector< std::string > >( );
+
+	run(
+		decompressed.consume( [ received ]( q::byte_block&& block )
+		{
+			received->push_back( block.to_string( ) );
+		} )
+		.then( [ received, expected ]( )
+		{
+			EXPECT_EQ( expected, *received );
+		} )
+	);
+}
+
+TEST_F( lz4, corrupt_channel_data_closes_with_error )
+{
+	q::channel< q::byte_block > ch( queue, 3 );
+
+	auto writable = ch.get_writable( );
+	auto decompressed = q::lz4::decompress( ch.get_readable( ), tp_queue );
+
+	q::ignore_result( writable.write( q::byte_block( "not lz4" ) ) );
+
+	EVENTUALLY_EXPECT_REJECTION_WITH(
+		decompressed.consume( [ ]( q::byte_block&& ) { } ),
+		q::lz4::corrupt_data_exception );
+}
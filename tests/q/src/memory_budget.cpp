@@ -0,0 +1,109 @@
+
+#include "core.hpp"
+
+#include <q/memory_budget.hpp>
+#include <q/channel.hpp>
+
+Q_TEST_MAKE_SCOPE( memory_budget );
+
+TEST_F( memory_budget, reservations_are_granted_in_order )
+{
+	auto budget = q::memory_budget::construct( 100 );
+
+	auto first = std::make_shared< q::memory_reservation >(
+		budget->try_reserve( 60 ) );
+
+	EXPECT_TRUE( !!*first );
+	EXPECT_FALSE( !!budget->try_reserve( 50 ) );
+
+	auto order = std::make_shared< std::vector< std::size_t > >( );
+
+	auto big = budget->reserve( queue, 50 )
+	.then( [ order ]( q::memory_reservation reservation )
+	{
+		order->push_back( reservation.bytes( ) );
+	} );
+
+	// Fits, but must wait behind the bigger one
+	auto small = budget->reserve( queue, 10 )
+	.then( [ order ]( q::memory_reservation reservation )
+	{
+		order->push_back( reservation.bytes( ) );
+	} );
+
+	EXPECT_EQ( 2u, budget->waiting( ) );
+
+	first->release( );
+
+	run(
+		q::all( std::move( big ), std::move( small ) )
+		.then( [ order, budget ]( )
+		{
+			ASSERT_EQ( 2u, order->size( ) );
+			EXPECT_EQ( 50u, ( *order )[ 0 ] );
+			EXPECT_EQ( 10u, ( *order )[ 1 ] );
+			EXPECT_EQ( 0u, budget->used( ) );
+		} )
+	);
+}
+
+TEST_F( memory_budget, byte_block_keeps_reservation )
+{
+	auto budget = q::memory_budget::construct( 100 );
+
+	auto data = std::shared_ptr< const std::uint8_t >(
+		new std::uint8_t[ 10 ],
+		[ ]( const std::uint8_t* p ) { delete[ ] p; } );
+
+	auto block = q::make_unique< q::byte_block >(
+		10, data, budget->force_reserve( 10 ) );
+	data.reset( );
+
+	auto slice = block->slice( 5 );
+
+	EXPECT_EQ( 10u, budget->used( ) );
+
+	block.reset( );
+	EXPECT_EQ( 10u, budget->used( ) );
+
+	slice = q::byte_block( );
+	EXPECT_EQ( 0u, budget->used( ) );
+}
+
+TEST_F( memory_budget, channel_applies_memory_pressure )
+{
+	auto budget = q::memory_budget::construct( 10 );
+
+	q::channel< q::byte_block > ch( queue, 100 );
+	ch.set_memory_budget( budget );
+
+	auto readable = ch.get_readable( );
+	auto writable = ch.get_writable( );
+
+	EXPECT_TRUE( writable.write( q::byte_block( std::string( 8, 'a' ) ) ) );
+	EXPECT_TRUE( writable.should_write( ) );
+	EXPECT_TRUE( writable.write( q::byte_block( std::string( 8, 'b' ) ) ) );
+	EXPECT_FALSE( writable.should_write( ) );
+	EXPECT_EQ( 16u, budget->used( ) );
+
+	auto resumed = std::make_shared< bool >( false );
+
+	writable.set_resume_notification( [ resumed ]( )
+	{
+		*resumed = true;
+	} );
+
+	run(
+		readable.read( )
+		.then( [ budget ]( q::byte_block block )
+		{
+			EXPECT_EQ( 8u, block.size( ) );
+			EXPECT_EQ( 8u, budget->used( ) );
+		} )
+		.then( [ resumed, writable ]( )
+		{
+			EXPECT_TRUE( *resumed );
+			EXPECT_TRUE( writable.should_write( ) );
+		} )
+	);
+}
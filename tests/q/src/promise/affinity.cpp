@@ -0,0 +1,41 @@
+
+#include "../core.hpp"
+
+#include <thread>
+
+Q_TEST_MAKE_SCOPE( affinity );
+
+TEST_F( affinity, continuation_runs_on_resolving_thread )
+{
+	run(
+		q::with( queue )
+		.then( [ ]( ) { }, queue )
+		.use_queue( tp_queue )
+		.then( [ ]( )
+		{
+			return std::this_thread::get_id( );
+		} )
+		.then( EXPECT_CALL_WRAPPER( [ ]( std::thread::id resolver )
+		{
+			EXPECT_EQ( resolver, std::this_thread::get_id( ) );
+		} ), q::affinity::resolver )
+	);
+}
+
+TEST_F( affinity, falls_back_to_queue_for_other_threads )
+{
+	auto caller = std::this_thread::get_id( );
+
+	run(
+		q::with( queue )
+		.then( [ ]( ) { }, queue )
+		.use_queue( tp_queue )
+		.then( EXPECT_CALL_WRAPPER( [ caller ]( )
+		{
+			// Resolved by the blocking dispatcher, which isn't a
+			// thread of the threadpool, so it is scheduled on the
+			// threadpool as usual.
+			EXPECT_NE( caller, std::this_thread::get_id( ) );
+		} ), q::affinity::resolver )
+	);
+}
@@ -0,0 +1,63 @@
+
+#include "../core.hpp"
+
+Q_TEST_MAKE_SCOPE( async );
+
+TEST_F( async, function_returning_void )
+{
+	EVENTUALLY_EXPECT_RESOLUTION(
+		q::async( queue, EXPECT_CALL_WRAPPER( [ ]( ) { } ) ) );
+}
+
+TEST_F( async, function_getting_ints_returning_int )
+{
+	EVENTUALLY_EXPECT_EQ(
+		q::async( queue, [ ]( int a, int b ) { return a * b; }, 5, 3 ),
+		15 );
+}
+
+TEST_F( async, function_getting_movable_only )
+{
+	std::unique_ptr< int > value( new int( 17 ) );
+
+	EVENTUALLY_EXPECT_EQ(
+		q::async(
+			queue,
+			[ ]( std::unique_ptr< int >&& value ) { return *value; },
+			std::move( value ) ),
+		17 );
+}
+
+TEST_F( async, function_returning_promise )
+{
+	auto queue = this->queue;
+
+	EVENTUALLY_EXPECT_EQ(
+		q::async( queue, [ queue ]( int i )
+		{
+			return q::with( queue, i * 2 );
+		}, 5 ),
+		10 );
+}
+
+TEST_F( async, function_throwing )
+{
+	EVENTUALLY_EXPECT_REJECTION_WITH(
+		q::async( queue, [ ]( ) -> int
+		{
+			Q_THROW( Error( ) );
+		} ),
+		Error );
+}
+
+TEST_F( async, runs_on_given_queue )
+{
+	auto caller = std::this_thread::get_id( );
+
+	EVENTUALLY_EXPECT_NE(
+		q::async( tp_queue, [ ]( )
+		{
+			return std::this_thread::get_id( );
+		} ),
+		caller );
+}
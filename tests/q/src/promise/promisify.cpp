@@ -71,3 +71,39 @@ TEST_F( promisify, function_returning_int_promise )
 	EVENTUALLY_EXPECT_RESOLUTION( promise_fn( ) );
 	EVENTUALLY_EXPECT_EQ( promise_fn( ), 5 );
 }
+
+TEST_F( promisify, on_function_getting_int_returning_int )
+{
+	auto promisified = q::promisify_on( tp_queue, [ ]( int i ) -> int
+	{
+		return i * 2;
+	} );
+
+	EVENTUALLY_EXPECT_EQ( promisified( 5 ), 10 );
+	EVENTUALLY_EXPECT_EQ( promisified( 6 ), 12 );
+}
+
+TEST_F( promisify, on_function_runs_on_given_queue )
+{
+	auto caller = std::this_thread::get_id( );
+
+	auto promisified = q::promisify_on( tp_queue, [ ]( )
+	{
+		return std::this_thread::get_id( );
+	} );
+
+	EVENTUALLY_EXPECT_NE( promisified( ), caller );
+}
+
+TEST_F( promisify, on_function_returning_int_promise )
+{
+	auto queue = this->queue;
+
+	auto fn = EXPECT_CALL_WRAPPER(
+		[ queue ]( ) { return q::with( queue, 5 ); }
+	);
+
+	auto promise_fn = q::promisify_on( tp_queue, fn );
+
+	EVENTUALLY_EXPECT_EQ( promise_fn( ), 5 );
+}
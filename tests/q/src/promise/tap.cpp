@@ -120,3 +120,99 @@ TEST_F( tap, tuple_to_promise )
 		} ) )
 	);
 }
+
+namespace {
+
+struct move_counter
+{
+	move_counter( std::size_t* moves )
+	: moves_( moves )
+	{ }
+
+	move_counter( move_counter&& other )
+	: moves_( other.moves_ )
+	{
+		++*moves_;
+	}
+
+	move_counter( const move_counter& ) = delete;
+
+	std::size_t* moves_;
+};
+
+} // anonymous namespace
+
+TEST_F( tap, chained_taps_dont_move_value )
+{
+	// Number of moves; in total, and before the first tap
+	typedef std::pair< std::size_t, std::size_t > moves_type;
+	auto moves = std::make_shared< moves_type >( 0, 0 );
+
+	run(
+		q::with( queue )
+		.then( [ moves ]( )
+		{
+			return move_counter( &moves->first );
+		} )
+		.tap( EXPECT_CALL_WRAPPER( [ moves ]( const move_counter& )
+		{
+			moves->second = moves->first;
+		} ) )
+		.tap( EXPECT_CALL_WRAPPER( [ ]( const move_counter& ) { } ) )
+		.tap( EXPECT_CALL_WRAPPER( [ ]( const move_counter& ) { } ) )
+		.tap( EXPECT_CALL_WRAPPER( [ ]( const move_counter& ) { } ) )
+		.then( EXPECT_CALL_WRAPPER( [ moves ]( move_counter&& )
+		{
+			// The value is moved out of the future once, and then
+			// once more to be consumed, regardless of the number of
+			// taps in between.
+			EXPECT_LE( moves->first, moves->second + 2 );
+		} ) )
+	);
+}
+
+TEST_F( tap, failing_tap_rejects_chain )
+{
+	run(
+		q::with( queue, 17 )
+		.tap( EXPECT_CALL_WRAPPER( [ ]( int )
+		{
+			Q_THROW( Error( ) );
+		} ) )
+		.then( EXPECT_NO_CALL_WRAPPER( [ ]( int ) { } ) )
+		.fail( EXPECT_CALL_WRAPPER( [ ]( const Error& ) { } ) )
+	);
+}
+
+TEST_F( tap, tap_then_share )
+{
+	run(
+		q::with( queue, 17 )
+		.tap( EXPECT_CALL_WRAPPER( [ ]( int value )
+		{
+			EXPECT_EQ( 17, value );
+		} ) )
+		.share( )
+		.then( EXPECT_CALL_WRAPPER( [ ]( int value )
+		{
+			EXPECT_EQ( 17, value );
+		} ) )
+	);
+}
+
+TEST_F( tap, shared_promise )
+{
+	auto shared = q::with( queue, 17 ).share( );
+
+	run(
+		shared
+		.tap( EXPECT_CALL_WRAPPER( [ ]( int value )
+		{
+			EXPECT_EQ( 17, value );
+		} ) )
+		.then( EXPECT_CALL_WRAPPER( [ ]( int value )
+		{
+			EXPECT_EQ( 17, value );
+		} ) )
+	);
+}
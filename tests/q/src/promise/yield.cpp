@@ -0,0 +1,110 @@
+
+#include "../core.hpp"
+
+#include <string>
+
+Q_TEST_MAKE_SCOPE( yield );
+
+namespace {
+
+q::promise< > process(
+	const q::queue_ptr& queue,
+	const std::shared_ptr< std::string >& log,
+	char name,
+	int remaining
+)
+{
+	while ( remaining-- > 0 )
+	{
+		log->push_back( name );
+
+		if (
+			remaining > 0 &&
+			q::this_task::should_yield( q::timer::duration_type::zero( ) )
+		)
+			return q::yield( queue )
+			.then( [ queue, log, name, remaining ]( )
+			{
+				return process( queue, log, name, remaining );
+			} );
+	}
+
+	return q::with( queue );
+}
+
+} // anonymous namespace
+
+TEST_F( yield, not_without_waiting_tasks )
+{
+	run(
+		q::with( queue )
+		.then( EXPECT_CALL_WRAPPER( [ ]( )
+		{
+			auto zero = q::timer::duration_type::zero( );
+
+			EXPECT_FALSE( q::this_task::should_yield( zero ) );
+			EXPECT_FALSE( q::this_task::should_yield( zero ) );
+		} ) )
+	);
+}
+
+TEST_F( yield, not_within_time_slice )
+{
+	auto queue = this->queue;
+
+	run(
+		q::with( queue )
+		.then( EXPECT_CALL_WRAPPER( [ queue ]( )
+		{
+			auto slice = std::chrono::hours( 1 );
+
+			queue->push( [ ]( ) { } );
+
+			EXPECT_FALSE( q::this_task::should_yield( slice ) );
+			EXPECT_FALSE( q::this_task::should_yield( slice ) );
+		} ) )
+	);
+}
+
+TEST_F( yield, when_time_slice_exceeded_and_tasks_waiting )
+{
+	auto queue = this->queue;
+
+	run(
+		q::with( queue )
+		.then( EXPECT_CALL_WRAPPER( [ queue ]( )
+		{
+			auto zero = q::timer::duration_type::zero( );
+
+			queue->push( [ ]( ) { } );
+
+			EXPECT_FALSE( q::this_task::should_yield( zero ) );
+			EXPECT_TRUE( q::this_task::should_yield( zero ) );
+		} ) )
+	);
+}
+
+TEST_F( yield, long_tasks_interleave )
+{
+	auto queue = this->queue;
+	auto log = std::make_shared< std::string >( );
+
+	std::vector< q::promise< > > promises;
+
+	promises.push_back( q::with( queue ).then( [ queue, log ]( )
+	{
+		return process( queue, log, 'a', 6 );
+	} ) );
+	promises.push_back( q::with( queue ).then( [ queue, log ]( )
+	{
+		return process( queue, log, 'b', 6 );
+	} ) );
+
+	run(
+		q::all( std::move( promises ), queue )
+		.then( [ log ]( )
+		{
+			EXPECT_EQ( "aabbaabbaabb", *log );
+		} )
+	);
+}
@@ -0,0 +1,81 @@
+
+#include "core.hpp"
+
+#include <q/queue.hpp>
+#include <q/execution_context.hpp>
+#include <q/blocking_dispatcher.hpp>
+
+#include <vector>
+
+namespace {
+
+q::task make_task( std::vector< int >& order, int id )
+{
+	return [ &order, id ]( )
+	{
+		order.push_back( id );
+	};
+}
+
+void pop_all( const q::queue_ptr& queue )
+{
+	while ( !queue->empty( ) )
+		queue->pop( ).task_( );
+}
+
+} // anonymous namespace
+
+TEST( queue, fifo_within_priority_class )
+{
+	auto queue = q::queue::construct( 0 );
+	std::vector< int > order;
+
+	for ( int i = 0; i < 5; ++i )
+		queue->push( make_task( order, i ) );
+
+	pop_all( queue );
+
+	EXPECT_EQ( std::vector< int >( { 0, 1, 2, 3, 4 } ), order );
+}
+
+TEST( queue, higher_priority_classes_overtake )
+{
+	auto queue = q::queue::construct( 0 );
+	std::vector< int > order;
+
+	queue->push( make_task( order, 1 ), q::priority_class::background );
+	queue->push( make_task( order, 2 ) );
+	queue->push( make_task( order, 3 ), q::priority_class::urgent );
+	queue->push( make_task( order, 4 ), q::priority_class::high );
+	queue->push( make_task( order, 5 ), q::priority_class::urgent );
+	queue->push( make_task( order, 6 ), q::priority_class::background );
+
+	EXPECT_FALSE( queue->empty( ) );
+
+	pop_all( queue );
+
+	EXPECT_EQ( std::vector< int >( { 3, 5, 4, 2, 1, 6 } ), order );
+	EXPECT_TRUE( queue->empty( ) );
+	EXPECT_FALSE( queue->pop( ) );
+}
+
+TEST( queue, priority_classes_in_execution_context )
+{
+	auto ec = q::make_execution_context<
+		q::blocking_dispatcher, q::direct_scheduler
+	>( "test" );
+	auto queue = ec->queue( );
+	std::vector< int > order;
+
+	queue->push( make_task( order, 1 ), q::priority_class::background );
+	queue->push( make_task( order, 2 ) );
+	queue->push( [ &order, ec ]( )
+	{
+		order.push_back( 3 );
+		ec->dispatcher( )->terminate( q::termination::linger );
+	}, q::priority_class::urgent );
+
+	ec->dispatcher( )->start( );
+
+	EXPECT_EQ( std::vector< int >( { 3, 2, 1 } ), order );
+}
@@ -0,0 +1,164 @@
+
+#include "core.hpp"
+
+#include <q/resource_pool.hpp>
+
+Q_TEST_MAKE_SCOPE( resource_pool );
+
+namespace {
+
+q::resource_pool< int >
+make_counting_pool(
+	const q::queue_ptr& queue,
+	std::shared_ptr< int > created,
+	std::size_t max
+)
+{
+	return q::resource_pool< int >(
+		queue,
+		[ created ]( )
+		{
+			return q::make_unique< int >( ++*created );
+		},
+		max );
+}
+
+} // anonymous namespace
+
+TEST_F( resource_pool, reuses_idle_objects )
+{
+	auto created = std::make_shared< int >( 0 );
+	auto pool = make_counting_pool( queue, created, 4 );
+
+	run(
+		pool.acquire( )
+		.then( [ pool ]( q::pooled< int > object ) mutable
+		{
+			EXPECT_EQ( 1, *object );
+			object.reset( );
+
+			EXPECT_EQ( 1u, pool.idle( ) );
+
+			return pool.acquire( );
+		} )
+		.then( [ pool, created ]( q::pooled< int > object )
+		{
+			EXPECT_EQ( 1, *object );
+			EXPECT_EQ( 1, *created );
+			EXPECT_EQ( 1u, pool.size( ) );
+			EXPECT_EQ( 0u, pool.idle( ) );
+			EXPECT_EQ( 2u, pool.statistics( ).acquired );
+			// Only the first one waited, for the object to be created
+			EXPECT_EQ( 1u, pool.statistics( ).waited );
+		} )
+	);
+}
+
+TEST_F( resource_pool, hands_released_objects_to_waiters )
+{
+	auto created = std::make_shared< int >( 0 );
+	auto pool = make_counting_pool( queue, created, 2 );
+
+	auto first = std::make_shared< q::pooled< int > >( );
+	auto second = std::make_shared< q::pooled< int > >( );
+
+	run(
+		pool.acquire( )
+		.then( [ pool, first ]( q::pooled< int > object ) mutable
+		{
+			*first = std::move( object );
+			return pool.acquire( );
+		} )
+		.then( [ pool, first, second ]( q::pooled< int > object )
+		mutable
+		{
+			*second = std::move( object );
+
+			EXPECT_EQ( 2u, pool.size( ) );
+
+			// The pool is exhausted, so these have to wait
+			auto third = pool.acquire( );
+			auto fourth = std::make_shared<
+				q::promise< q::pooled< int > > >( pool.acquire( ) );
+
+			EXPECT_EQ( 2u, pool.waiting( ) );
+
+			second->reset( );
+			first->reset( );
+
+			return third
+			.then( [ fourth ]( q::pooled< int > object ) mutable
+			{
+				EXPECT_EQ( 2, *object );
+
+				return std::move( *fourth );
+			} );
+		} )
+		.then( [ pool, created ]( q::pooled< int > object )
+		{
+			EXPECT_EQ( 1, *object );
+			EXPECT_EQ( 2, *created );
+			EXPECT_EQ( 0u, pool.waiting( ) );
+
+			auto stats = pool.statistics( );
+			EXPECT_EQ( 4u, stats.acquired );
+			// Including the first two, waiting for them to be created
+			EXPECT_EQ( 4u, stats.waited );
+			EXPECT_EQ( 2u, stats.created );
+		} )
+	);
+}
+
+TEST_F( resource_pool, factory_errors_reject_acquirers )
+{
+	q::resource_pool< int > pool(
+		queue,
+		[ ]( ) -> std::unique_ptr< int >
+		{
+			throw Error( );
+		},
+		1 );
+
+	auto failed = std::make_shared< bool >( false );
+
+	run(
+		pool.acquire( )
+		.then( [ ]( q::pooled< int > )
+		{
+			ADD_FAILURE( );
+		} )
+		.fail( [ failed, pool ]( Error& )
+		{
+			*failed = true;
+
+			EXPECT_EQ( 0u, pool.size( ) );
+		} )
+	);
+
+	EXPECT_TRUE( *failed );
+}
+
+TEST_F( resource_pool, evicts_idle_objects )
+{
+	auto created = std::make_shared< int >( 0 );
+	auto pool = make_counting_pool( queue, created, 2 );
+
+	pool.set_idle_timeout( std::chrono::milliseconds( 1 ) );
+
+	run(
+		pool.acquire( )
+		.then( [ pool ]( q::pooled< int > object )
+		{
+			object.reset( );
+
+			EXPECT_EQ( 1u, pool.idle( ) );
+		} )
+		.delay( std::chrono::milliseconds( 20 ) )
+		.then( [ pool ]( )
+		{
+			EXPECT_EQ( 0u, pool.size( ) );
+			EXPECT_EQ( 0u, pool.idle( ) );
+			EXPECT_EQ( 1u, pool.statistics( ).evicted );
+		} )
+	);
+}
@@ -0,0 +1,69 @@
+
+#include "core.hpp"
+
+#include <q/time_set.hpp>
+#include <q/promise.hpp>
+
+Q_TEST_MAKE_SCOPE( time_set );
+
+TEST_F( time_set, next_time_includes_slack )
+{
+	q::time_set< int > set;
+
+	auto now = q::timer::point_type::clock::now( );
+
+	set.push( now + std::chrono::milliseconds( 100 ), 1,
+		std::chrono::milliseconds( 400 ) );
+	set.push( now + std::chrono::milliseconds( 200 ), 2,
+		std::chrono::milliseconds( 100 ) );
+
+	// The first element must be handled before 500ms, the second before
+	// 300ms, so one wake-up at ~300ms handles both
+	auto next = set.next_time( );
+	EXPECT_GT( next, std::chrono::milliseconds( 200 ) );
+	EXPECT_LE( next, std::chrono::milliseconds( 300 ) );
+
+	EXPECT_FALSE( set.exists_before_or_at( now ) );
+	EXPECT_TRUE( set.exists_before_or_at(
+		now + std::chrono::milliseconds( 300 ) ) );
+
+	EXPECT_EQ( 1, set.pop( ) );
+
+	next = set.next_time( );
+	EXPECT_GT( next, std::chrono::milliseconds( 200 ) );
+	EXPECT_LE( next, std::chrono::milliseconds( 300 ) );
+
+	EXPECT_EQ( 2, set.pop( ) );
+	EXPECT_TRUE( set.empty( ) );
+	EXPECT_EQ( q::timer::duration_type::max( ), set.next_time( ) );
+}
+
+TEST_F( time_set, queue_slack_coalesces_timers )
+{
+	queue->set_timer_slack( std::chrono::milliseconds( 50 ) );
+
+	EXPECT_EQ( std::chrono::milliseconds( 50 ), queue->timer_slack( ) );
+
+	auto counter = std::make_shared< int >( 0 );
+
+	for ( int i = 1; i <= 10; ++i )
+		q::delay( queue, std::chrono::milliseconds( i ) )
+		.then( [ counter ]( )
+		{
+			++*counter;
+		} );
+
+	auto bd_ = bd;
+
+	run(
+		q::delay( queue, std::chrono::milliseconds( 11 ) )
+		.then( [ counter, bd_ ]( )
+		{
+			EXPECT_EQ( 10, *counter );
+
+			// All timers expire within the slack of the first one,
+			// so they share (almost) a single wake-up
+			EXPECT_LE( bd_->statistics( ).timer_wakeups, 2u );
+		} )
+	);
+}
@@ -0,0 +1,111 @@
+#include "core.hpp"
+
+#include <q/worker_local.hpp>
+#include <q/threadpool.hpp>
+
+#include <atomic>
+
+Q_TEST_MAKE_SCOPE( worker_local );
+
+namespace {
+
+struct counted
+{
+	counted( std::shared_ptr< std::atomic< int > > destructed )
+	: destructed_( std::move( destructed ) )
+	, value( 0 )
+	{ }
+
+	~counted( )
+	{
+		++*destructed_;
+	}
+
+	std::shared_ptr< std::atomic< int > > destructed_;
+	std::atomic< std::size_t > value;
+};
+
+} // anonymous namespace
+
+TEST_F( worker_local, aggregates_worker_instances )
+{
+	q::worker_local< std::atomic< std::size_t > > counters( tp );
+
+	std::vector< q::promise< > > promises;
+	for ( std::size_t i = 0; i < 100; ++i )
+		promises.push_back( q::async( tp_queue, [ counters ]( ) mutable
+		{
+			++counters.local( );
+		} ) );
+
+	run(
+		q::all( std::move( promises ), queue )
+		.then( [ counters ]( )
+		{
+			EXPECT_GE( 2u, counters.size( ) );
+			EXPECT_LE( 1u, counters.size( ) );
+
+			auto sum = counters.aggregate( std::size_t( 0 ),
+				[ ]( std::size_t acc,
+				     const std::atomic< std::size_t >& value )
+				{
+					return acc + value.load( );
+				} );
+
+			EXPECT_EQ( 100u, sum );
+		} )
+	);
+}
+
+TEST_F( worker_local, throws_outside_of_workers )
+{
+	q::worker_local< int > local( tp );
+
+	EXPECT_THROW( local.local( ), q::not_a_worker_exception );
+
+	// Another dispatcher's thread isn't a worker of tp
+	run(
+		q::with( queue )
+		.then( [ local ]( ) mutable
+		{
+			EXPECT_THROW( *local, q::not_a_worker_exception );
+		} )
+	);
+}
+
+TEST_F( worker_local, destructs_instances_on_termination )
+{
+	auto destructed = std::make_shared< std::atomic< int > >( 0 );
+
+	auto pool = q::make_event_dispatcher_and_queue<
+		q::threadpool, q::direct_scheduler
+	>( "worker_local", queue, 2 );
+	auto pool_tp = std::get< 0 >( pool );
+	auto pool_queue = std::get< 1 >( pool );
+
+	q::worker_local< counted > local( pool_tp, [ destructed ]( )
+	{
+		return q::make_unique< counted >( destructed );
+	} );
+
+	std::vector< q::promise< > > promises;
+	for ( std::size_t i = 0; i < 20; ++i )
+		promises.push_back( q::async( pool_queue, [ local ]( ) mutable
+		{
+			++local->value;
+		} ) );
+
+	run(
+		q::all( std::move( promises ), queue )
+		.then( [ pool_tp ]( )
+		{
+			return pool_tp->terminate( q::termination::linger );
+		} )
+		.then( [ local, destructed ]( )
+		{
+			EXPECT_EQ( 0u, local.size( ) );
+			EXPECT_LE( 1, destructed->load( ) );
+			EXPECT_GE( 2, destructed->load( ) );
+		} )
+	);
+}
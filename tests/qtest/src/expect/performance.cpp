@@ -0,0 +1,63 @@
+
+#include "../core.hpp"
+
+#include <memory>
+#include <vector>
+
+Q_TEST_MAKE_SCOPE( expect_performance );
+
+TEST_F( expect_performance, allocation_counter )
+{
+	q::test::allocation_counter counter;
+
+	auto a = std::make_shared< int >( 1 );
+	std::vector< long > b( 4 );
+
+	counter.stop( );
+
+	auto c = std::make_shared< int >( 3 );
+
+	EXPECT_EQ( counter.allocations( ), 2u );
+	EXPECT_GE( counter.bytes( ), 4 * sizeof( long ) );
+}
+
+TEST_F( expect_performance, expect_max_allocations )
+{
+	std::size_t value = 0;
+
+	EXPECT_MAX_ALLOCATIONS( 8, {
+		value += 1;
+	} );
+
+	EXPECT_MAX_ALLOCATIONS_PER_ITERATION( 1, 100, {
+		std::unique_ptr< std::size_t > ptr( new std::size_t( value ) );
+		value = *ptr + 1;
+	} );
+
+	EXPECT_EQ( value, 101u );
+}
+
+TEST_F( expect_performance, then_allocations )
+{
+	// Adding a continuation currently allocates 7 times (with libstdc++).
+	// This guards against regressions, with some room for other standard
+	// libraries.
+	auto p = q::with( queue, 1 );
+
+	EXPECT_MAX_ALLOCATIONS( 8, {
+		p = p.then( [ ]( int i ) { return i + 1; } );
+	} );
+
+	run( p.then( [ ]( int i ) { EXPECT_EQ( i, 2 ); } ) );
+}
+
+TEST_F( expect_performance, expect_max_time_per_iteration )
+{
+	std::size_t value = 0;
+
+	EXPECT_MAX_TIME_PER_ITERATION( std::chrono::milliseconds( 10 ), 100, {
+		value += 1;
+	} );
+
+	EXPECT_EQ( value, 100u );
+}
@@ -0,0 +1,60 @@
+
+#include "core.hpp"
+
+Q_TEST_MAKE_SHARED_SCOPE( shared_runtime );
+
+TEST_F( shared_runtime, uses_the_shared_threadpool )
+{
+	EXPECT_EQ( tp, q::test::detail::shared_runtime::get( ).threadpool( ) );
+
+	auto p = q::with( queue, 5 )
+	.then( [ ]( int i ) { return i * 2; }, tp_queue )
+	.then( [ ]( int i ) { EXPECT_EQ( i, 10 ); } );
+
+	run( std::move( p ) );
+}
+
+TEST_F( shared_runtime, fresh_queue_per_test )
+{
+	EXPECT_NE( tp_queue, q::test::detail::shared_runtime::get( ).queue( ) );
+
+	auto p = q::with( queue, 1 )
+	.then( [ ]( int i ) { return i + 1; }, tp_queue )
+	.then( [ ]( int i ) { return i + 1; }, tp_queue )
+	.then( [ ]( int i ) { EXPECT_EQ( i, 3 ); } );
+
+	run( std::move( p ) );
+}
+
+// Checks, after teardown, that a task left on the pool has finished
+class shared_runtime_teardown
+: public q::test::fixture
+{
+public:
+	shared_runtime_teardown( )
+	: q::test::fixture( q::test::runtime_mode::shared )
+	, done_( false )
+	{ }
+
+	~shared_runtime_teardown( )
+	{
+		EXPECT_TRUE( done_.load( ) );
+	}
+
+protected:
+	std::atomic< bool > done_;
+};
+
+TEST_F( shared_runtime_teardown, awaits_pool_tasks )
+{
+	auto& done = done_;
+
+	// Not awaited by the test itself
+	tp_queue->push( [ &done ]( ) noexcept
+	{
+		std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+		done = true;
+	} );
+
+	run( q::with( queue ) );
+}
@@ -0,0 +1,131 @@
+#include "core.hpp"
+
+#include <q/channel.hpp>
+
+// Many writers write concurrently to a channel consumed on a threadpool. All
+// values must be consumed exactly once, and the consumption must complete
+// when the channel is closed.
+TEST( channel, concurrent_writers )
+{
+	const std::size_t writers = 4;
+	const std::size_t per_writer = 500;
+	const std::size_t total = writers * per_writer;
+
+	stress::pool pool( 3 );
+	auto queue = pool.queue( );
+
+	for ( std::size_t round = 0; round < stress::rounds( ); ++round )
+	{
+		q::channel< std::size_t > ch( queue, 16 );
+
+		auto readable = ch.get_readable( );
+		auto writable = ch.get_writable( );
+
+		std::atomic< std::size_t > consumed( 0 );
+		std::atomic< std::size_t > sum( 0 );
+		std::atomic< bool > done( false );
+
+		readable.consume( [ & ]( std::size_t value )
+		{
+			sum += value;
+			++consumed;
+		} )
+		.finally( [ & ]( )
+		{
+			done = true;
+		} );
+
+		std::atomic< std::size_t > accepted( 0 );
+
+		stress::run_threads( writers, [ & ]( std::size_t index )
+		{
+			for ( std::size_t i = 0; i < per_writer; ++i )
+				if ( writable.write( index * per_writer + i ) )
+					++accepted;
+		} );
+
+		writable.close( );
+
+		EXPECT_TRUE( stress::wait_until( [ & ]( )
+		{
+			return done.load( );
+		} ) );
+
+		EXPECT_EQ( total, accepted.load( ) );
+		EXPECT_EQ( total, consumed.load( ) ) << "in round " << round;
+		EXPECT_EQ( total * ( total - 1 ) / 2, sum.load( ) );
+	}
+}
+
+// The channel is closed while writers and readers are active. Exactly the
+// accepted writes must be read, and all pending reads must be settled.
+TEST( channel, close_racing_reads_and_writes )
+{
+	const std::size_t writers = 3;
+	const std::size_t readers = 3;
+	const std::size_t per_writer = 300;
+
+	stress::pool pool( 3 );
+	auto queue = pool.queue( );
+
+	for ( std::size_t round = 0; round < stress::rounds( ); ++round )
+	{
+		q::channel< int > ch( queue, 1000000 );
+
+		auto readable = ch.get_readable( );
+		auto writable = ch.get_writable( );
+
+		std::atomic< std::size_t > accepted( 0 );
+		std::atomic< std::size_t > values( 0 );
+		std::atomic< std::size_t > closed( 0 );
+		std::atomic< std::size_t > reads( 0 );
+
+		std::function< void( ) > read_next;
+		read_next = [ & ]( )
+		{
+			++reads;
+
+			readable.read( )
+			.then( [ & ]( int )
+			{
+				++values;
+				read_next( );
+			} )
+			.fail( [ & ]( q::channel_closed_exception )
+			{
+				++closed;
+			} );
+		};
+
+		stress::run_threads( writers + readers + 1,
+			[ & ]( std::size_t index )
+		{
+			if ( index < writers )
+			{
+				for ( std::size_t i = 0; i < per_writer; ++i )
+					if ( writable.write( 1 ) )
+						++accepted;
+			}
+			else if ( index < writers + readers )
+			{
+				queue->push( [ & ]( ) { read_next( ); } );
+			}
+			else
+			{
+				std::this_thread::sleep_for(
+					std::chrono::microseconds( 100 ) );
+				writable.close( );
+			}
+		} );
+
+		// Every read chain ends with a closed rejection
+		EXPECT_TRUE( stress::wait_until( [ & ]( )
+		{
+			return closed.load( ) == readers;
+		} ) );
+
+		EXPECT_EQ( accepted.load( ), values.load( ) )
+			<< "in round " << round;
+		EXPECT_EQ( values.load( ) + readers, reads.load( ) );
+	}
+}
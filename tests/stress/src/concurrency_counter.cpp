@@ -0,0 +1,80 @@
+#include "core.hpp"
+
+#include <q/concurrency_counter.hpp>
+
+// Threads increment and decrement the counter up to its limit and wait for
+// capacity through get_promise( ). The counter must end at zero, the zero
+// function must have been called, and all capacity promises must resolve.
+TEST( concurrency_counter, inc_dec_and_waiters )
+{
+	const std::size_t threads = 4;
+	const std::size_t per_thread = 300;
+	const std::size_t limit = 3;
+
+	stress::pool pool( 2 );
+	auto queue = pool.queue( );
+
+	for ( std::size_t round = 0; round < stress::rounds( ); ++round )
+	{
+		q::concurrency_counter counter( queue, limit );
+
+		std::atomic< std::size_t > zeroed( 0 );
+		std::atomic< std::size_t > waited( 0 );
+		std::atomic< std::size_t > over_limit( 0 );
+
+		counter.set_zero_function( [ &zeroed ]( )
+		{
+			++zeroed;
+		} );
+
+		// Serializes inc/dec pairs so that the counter never exceeds
+		// the limit, while get_promise( ) races freely with them.
+		std::atomic< std::size_t > slots( limit );
+
+		stress::run_threads( threads, [ & ]( std::size_t index )
+		{
+			for ( std::size_t i = 0; i < per_thread; ++i )
+			{
+				if ( ( i + index ) % 3 == 0 )
+				{
+					counter.get_promise( )
+					.then( [ &waited ]( )
+					{
+						++waited;
+					} );
+					continue;
+				}
+
+				auto available = slots.load( );
+				if ( available == 0 || !slots.compare_exchange_weak(
+					available, available - 1 ) )
+				{
+					std::this_thread::yield( );
+					continue;
+				}
+
+				counter.inc( );
+				if ( counter.get( ) > limit )
+					++over_limit;
+				counter.dec( );
+
+				++slots;
+			}
+		} );
+
+		std::size_t promised = 0;
+		for ( std::size_t index = 0; index < threads; ++index )
+			for ( std::size_t i = 0; i < per_thread; ++i )
+				if ( ( i + index ) % 3 == 0 )
+					++promised;
+
+		EXPECT_TRUE( stress::wait_until( [ & ]( )
+		{
+			return waited.load( ) == promised;
+		} ) ) << "in round " << round;
+
+		EXPECT_EQ( 0u, counter.get( ) );
+		EXPECT_EQ( 0u, over_limit.load( ) );
+		EXPECT_GT( zeroed.load( ), 0u );
+	}
+}
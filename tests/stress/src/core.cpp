@@ -0,0 +1,129 @@
+#include "core.hpp"
+
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+
+namespace stress {
+
+namespace {
+
+std::uint32_t initial_seed( )
+{
+	const char* env = std::getenv( "Q_STRESS_SEED" );
+	if ( env && *env )
+		return static_cast< std::uint32_t >(
+			std::strtoul( env, nullptr, 10 ) );
+
+	return std::random_device( )( );
+}
+
+std::atomic< std::size_t > injections_( 0 );
+std::atomic< std::uint32_t > thread_counter_( 0 );
+
+void inject( const char* )
+{
+	thread_local std::minstd_rand rng(
+		seed( ) + 7919 * thread_counter_.fetch_add( 1 ) );
+
+	injections_.fetch_add( 1, std::memory_order_relaxed );
+
+	auto r = rng( ) % 100;
+
+	if ( r < 10 )
+		std::this_thread::yield( );
+	else if ( r < 12 )
+		std::this_thread::sleep_for(
+			std::chrono::microseconds( rng( ) % 100 ) );
+}
+
+} // anonymous namespace
+
+std::uint32_t seed( )
+{
+	static const std::uint32_t seed_ = initial_seed( );
+	return seed_;
+}
+
+std::size_t rounds( )
+{
+	const char* env = std::getenv( "Q_STRESS_ROUNDS" );
+	if ( env && *env )
+		return std::strtoul( env, nullptr, 10 );
+
+	return 20;
+}
+
+std::size_t injections( )
+{
+	return injections_.load( );
+}
+
+void install_injection( )
+{
+	q::detail::set_stress_hook( &inject );
+}
+
+void run_threads( std::size_t count, std::function< void( std::size_t ) > fn )
+{
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool go = false;
+
+	std::vector< std::thread > threads;
+	threads.reserve( count );
+
+	for ( std::size_t i = 0; i < count; ++i )
+		threads.emplace_back( [ &, i ]( )
+		{
+			{
+				std::unique_lock< std::mutex > lock( mutex );
+				cond.wait( lock, [ & ]( ) { return go; } );
+			}
+
+			fn( i );
+		} );
+
+	{
+		std::unique_lock< std::mutex > lock( mutex );
+		go = true;
+	}
+	cond.notify_all( );
+
+	for ( auto& thread : threads )
+		thread.join( );
+}
+
+bool wait_until(
+	std::function< bool( ) > pred,
+	std::chrono::milliseconds timeout )
+{
+	auto deadline = std::chrono::steady_clock::now( ) + timeout;
+
+	while ( !pred( ) )
+	{
+		if ( std::chrono::steady_clock::now( ) >= deadline )
+			return pred( );
+
+		std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+	}
+
+	return true;
+}
+
+pool::pool( std::size_t threads )
+: termination_queue_( q::queue::construct( 0 ) )
+{
+	std::tie( tp_, queue_ ) = q::make_event_dispatcher_and_queue<
+		q::threadpool, q::direct_scheduler
+	>( "stress pool", termination_queue_, threads );
+}
+
+pool::~pool( )
+{
+	tp_->terminate( q::termination::linger );
+	tp_->await_termination( );
+}
+
+} // namespace stress
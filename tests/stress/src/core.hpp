@@ -0,0 +1,84 @@
+#ifndef LIBQ_TESTS_STRESS_CORE_HPP
+#define LIBQ_TESTS_STRESS_CORE_HPP
+
+#include <gtest/gtest.h>
+
+#include <q/detail/stress.hpp>
+#include <q/execution_context.hpp>
+#include <q/threadpool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#ifndef LIBQ_STRESS_INJECTION
+#	error The stress tests must be built against q-stress
+#endif
+
+namespace stress {
+
+/**
+ * The seed of the injected yields and sleeps, from the environment variable
+ * Q_STRESS_SEED or random. It is printed at startup, so that a failing run
+ * can be retried with the same seed (although the interleavings will still
+ * differ, since they depend on the OS scheduler).
+ */
+std::uint32_t seed( );
+
+/**
+ * The number of rounds each test runs, from Q_STRESS_ROUNDS, or 20.
+ */
+std::size_t rounds( );
+
+/**
+ * The number of times injection points have been passed (in any thread).
+ */
+std::size_t injections( );
+
+/**
+ * Installs the injection hook, which randomly yields or sleeps at the
+ * annotated points in q.
+ */
+void install_injection( );
+
+/**
+ * Runs fn( index ) in @c count threads, started as simultaneously as
+ * possible, and joins them.
+ */
+void run_threads( std::size_t count, std::function< void( std::size_t ) > fn );
+
+/**
+ * Waits (polling) until @c pred returns true, or the timeout expires.
+ *
+ * @returns the last result of @c pred
+ */
+bool wait_until(
+	std::function< bool( ) > pred,
+	std::chrono::milliseconds timeout = std::chrono::seconds( 30 ) );
+
+/**
+ * A threadpool and its queue, terminated (with linger) when destructed.
+ */
+class pool
+{
+public:
+	pool( std::size_t threads );
+	~pool( );
+
+	const q::queue_ptr& queue( ) const
+	{
+		return queue_;
+	}
+
+private:
+	q::queue_ptr termination_queue_;
+	std::shared_ptr< q::threadpool > tp_;
+	q::queue_ptr queue_;
+};
+
+} // namespace stress
+
+#endif // LIBQ_TESTS_STRESS_CORE_HPP
@@ -0,0 +1,27 @@
+#include "core.hpp"
+
+#include <q/lib.hpp>
+
+#include <iostream>
+
+int main( int argc, char** argv )
+{
+	q::settings settings;
+	auto scope = q::scoped_initialize( settings );
+
+	::testing::InitGoogleTest( &argc, argv );
+
+	std::cout
+		<< "Stress seed: " << stress::seed( )
+		<< ", rounds: " << stress::rounds( ) << std::endl;
+
+	stress::install_injection( );
+
+	auto ret = RUN_ALL_TESTS( );
+
+	std::cout
+		<< "Passed " << stress::injections( )
+		<< " injection points" << std::endl;
+
+	return ret;
+}
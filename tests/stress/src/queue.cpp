@@ -0,0 +1,115 @@
+#include "core.hpp"
+
+#include <q/queue.hpp>
+
+#include <memory>
+
+// Producers push tasks of mixed priority classes (and timed tasks) to a queue
+// which is concurrently popped by consumers. Every task must run exactly once.
+TEST( queue, concurrent_push_and_pop )
+{
+	const std::size_t producers = 4;
+	const std::size_t consumers = 4;
+	const std::size_t per_producer = 500;
+	const std::size_t total = producers * per_producer;
+
+	for ( std::size_t round = 0; round < stress::rounds( ); ++round )
+	{
+		auto queue = q::queue::construct( 0 );
+
+		std::unique_ptr< std::atomic< int >[ ] > runs(
+			new std::atomic< int >[ total ] );
+		for ( std::size_t i = 0; i < total; ++i )
+			runs[ i ] = 0;
+
+		std::atomic< std::size_t > pushed( 0 );
+		std::atomic< std::size_t > executed( 0 );
+
+		stress::run_threads( producers + consumers,
+			[ & ]( std::size_t index )
+		{
+			if ( index < producers )
+			{
+				for ( std::size_t i = 0; i < per_producer; ++i )
+				{
+					auto id = index * per_producer + i;
+					auto* run = &runs[ id ];
+
+					q::task task( [ run ]( ) noexcept
+					{
+						++*run;
+					} );
+
+					if ( i % 7 == 0 )
+						queue->push( std::move( task ),
+							q::timer::clock::now( ) );
+					else
+						queue->push( std::move( task ),
+							static_cast< q::priority_class >(
+								i % q::queue::num_priority_classes ) );
+
+					++pushed;
+				}
+				return;
+			}
+
+			while ( executed.load( ) < total )
+			{
+				auto tt = queue->pop( );
+				if ( !tt )
+				{
+					std::this_thread::yield( );
+					continue;
+				}
+
+				tt.task_( );
+				++executed;
+			}
+		} );
+
+		EXPECT_EQ( total, pushed.load( ) );
+		EXPECT_EQ( total, executed.load( ) );
+		EXPECT_TRUE( queue->empty( ) );
+
+		std::size_t wrong = 0;
+		for ( std::size_t i = 0; i < total; ++i )
+			if ( runs[ i ].load( ) != 1 )
+				++wrong;
+
+		EXPECT_EQ( 0u, wrong ) << "in round " << round;
+	}
+}
+
+// Tasks pushed from many threads to a threadpool queue are all run.
+TEST( queue, concurrent_push_to_threadpool )
+{
+	const std::size_t producers = 4;
+	const std::size_t per_producer = 500;
+	const std::size_t total = producers * per_producer;
+
+	for ( std::size_t round = 0; round < stress::rounds( ); ++round )
+	{
+		std::atomic< std::size_t > executed( 0 );
+
+		{
+			stress::pool pool( 3 );
+			auto queue = pool.queue( );
+
+			stress::run_threads( producers, [ & ]( std::size_t )
+			{
+				for ( std::size_t i = 0; i < per_producer; ++i )
+					queue->push( [ &executed ]( ) noexcept
+					{
+						++executed;
+					} );
+			} );
+
+			EXPECT_TRUE( stress::wait_until( [ & ]( )
+			{
+				return executed.load( ) == total;
+			} ) );
+		}
+
+		EXPECT_EQ( total, executed.load( ) ) << "in round " << round;
+	}
+}
@@ -0,0 +1,100 @@
+#include "core.hpp"
+
+#include <q/promise.hpp>
+
+// Continuations are added to a shared promise from many threads, while
+// another thread resolves it. Every continuation must run exactly once,
+// whether added before or after the resolution.
+TEST( promise_signal, continuations_racing_resolution )
+{
+	const std::size_t attachers = 4;
+	const std::size_t per_attacher = 100;
+	const std::size_t total = attachers * per_attacher;
+
+	stress::pool pool( 3 );
+	auto queue = pool.queue( );
+
+	for ( std::size_t round = 0; round < stress::rounds( ); ++round )
+	{
+		auto defer = q::detail::defer< int >::construct( queue );
+		auto shared = defer->get_promise( ).share( );
+
+		std::atomic< std::size_t > executed( 0 );
+		std::atomic< std::size_t > wrong( 0 );
+
+		stress::run_threads( attachers + 1, [ & ]( std::size_t index )
+		{
+			if ( index == attachers )
+			{
+				std::this_thread::yield( );
+				defer->set_value( 17 );
+				return;
+			}
+
+			for ( std::size_t i = 0; i < per_attacher; ++i )
+				shared.then( [ & ]( int value )
+				{
+					if ( value != 17 )
+						++wrong;
+					++executed;
+				} );
+		} );
+
+		EXPECT_TRUE( stress::wait_until( [ & ]( )
+		{
+			return executed.load( ) >= total;
+		} ) );
+
+		// Let potential duplicate executions surface
+		std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+
+		EXPECT_EQ( total, executed.load( ) ) << "in round " << round;
+		EXPECT_EQ( 0u, wrong.load( ) );
+	}
+}
+
+// Promise chains hopping between threads of a pool preserve order and values.
+TEST( promise_signal, chains_across_threads )
+{
+	const std::size_t chains = 50;
+	const int length = 20;
+
+	stress::pool pool( 4 );
+	auto queue = pool.queue( );
+
+	for ( std::size_t round = 0; round < stress::rounds( ); ++round )
+	{
+		std::atomic< std::size_t > finished( 0 );
+		std::atomic< std::size_t > wrong( 0 );
+
+		stress::run_threads( 4, [ & ]( std::size_t )
+		{
+			for ( std::size_t c = 0; c < chains / 4; ++c )
+			{
+				auto p = q::with( queue, 0 );
+
+				for ( int i = 0; i < length; ++i )
+					p = p.then( [ i, &wrong ]( int value )
+					{
+						if ( value != i )
+							++wrong;
+						return value + 1;
+					} );
+
+				p.then( [ & ]( int value )
+				{
+					if ( value != length )
+						++wrong;
+					++finished;
+				} );
+			}
+		} );
+
+		EXPECT_TRUE( stress::wait_until( [ & ]( )
+		{
+			return finished.load( ) == ( chains / 4 ) * 4;
+		} ) );
+
+		EXPECT_EQ( 0u, wrong.load( ) ) << "in round " << round;
+	}
+}